@@ -47,6 +47,7 @@
 #include <mpfr.h>
 
 #include "dgs_misc.h"
+#include "dgs_rng.h"
 
 /**
    Number of bits sampled at once in ``dgs_bern_uniform_t``
@@ -66,6 +67,62 @@
 
 #define DGS_BERN_EXP_ALLOC_BLOCK_SIZE 16
 
+/**
+   ``dgs_bern_exp_dp_t`` reads `x` this many bits at a time, one table per digit
+*/
+
+#define DGS_BERN_EXP_DP_DIGIT_BITS 8
+#define DGS_BERN_EXP_DP_DIGIT_SIZE (1<<DGS_BERN_EXP_DP_DIGIT_BITS)
+
+/**
+   Multi-precision samplers working at a precision of at most this many bits
+   store probabilities as ``dgs_u128_t`` scaled to `2^128` instead of as
+   ``mpfr_t``, and compare them against random words without MPFR.
+*/
+
+#define DGS_MP_U128_MAX_PREC 128
+
+/**
+   Multi-precision tables of ``n`` entries at precision ``prec`` are filled on
+   all OpenMP threads if ``n·prec`` is at least this, and MPFR is thread safe.
+   Every entry is computed on its own, so the result does not depend on the
+   number of threads.
+*/
+
+#define DGS_MP_PARALLEL_MIN_WORK (1<<16)
+
+typedef unsigned __int128 dgs_u128_t;
+
+/**
+   Return `⌊2^128·p⌋` for `0 ≤ p ≤ 1`, or `2^128-1` if that overflows.
+
+   :param p: probability
+
+*/
+
+dgs_u128_t dgs_u128_set_mpfr(const mpfr_t p);
+
+/**
+   Return 1 with probability `p/2^128`.
+
+   This compares `p` with a uniform 128-bit integer, so it is as accurate as
+   ``dgs_bern_mp_call()`` at any precision up to 128 bits. The high words are
+   compared first and the low word is only drawn on a tie, so one 64-bit draw
+   suffices except with probability `2^{-64}`.
+
+   :param p: probability scaled to `2^128`
+   :param state: GMP randstate used as randomness source
+
+*/
+
+static inline long dgs_bern_u128_call(dgs_u128_t p, gmp_randstate_t state) {
+  const uint64_t hi = gmp_urandomb_ui(state, 64);
+  const uint64_t p_hi = (uint64_t)(p >> 64);
+  if (__DGS_LIKELY(hi != p_hi))
+    return hi < p_hi;
+  return gmp_urandomb_ui(state, 64) < (uint64_t)p;
+}
+
 /**
    Balanced Bernoulli distribution.
 
@@ -139,6 +196,70 @@ static inline unsigned long dgs_bern_uniform_call(dgs_bern_uniform_t *self, gmp_
   return b;
 }
 
+/**
+   Return ``k`` uniformly random bits at once, the bit ``dgs_bern_uniform_call()``
+   would have returned first being the least significant one.
+
+   :param self: Bernoulli state
+   :param state: GMP randstate used as randomness source
+   :param k: number of bits with ``k <= self->length``
+
+ */
+
+static inline unsigned long dgs_bern_uniform_bits(dgs_bern_uniform_t *self, gmp_randstate_t state, size_t k) {
+  assert(self != NULL);
+  assert(k <= self->length);
+  if (k == 0)
+    return 0;
+
+  unsigned long r = 0;
+  size_t got = self->length - self->count;
+  if (__DGS_UNLIKELY(got < k)) {
+    r = self->pool;
+    self->pool = gmp_urandomb_ui(state, self->length);
+    self->count = 0;
+  } else {
+    got = 0;
+  }
+
+  size_t need = k - got;
+  r |= (self->pool & __DGS_LSB_BITMASK(need)) << got;
+  self->pool = (need == (size_t)dgs_radix) ? 0 : self->pool >> need;
+  self->count += need;
+  return r;
+}
+
+/**
+   Consume uniformly random bits up to and including the first zero and return
+   the number of ones before it, found with one ``ctz`` per word of the pool.
+
+   :param self: Bernoulli state
+   :param state: GMP randstate used as randomness source
+
+ */
+
+static inline unsigned long dgs_bern_uniform_ones(dgs_bern_uniform_t *self, gmp_randstate_t state) {
+  assert(self != NULL);
+  unsigned long n = 0;
+  while (1) {
+    if (__DGS_UNLIKELY(self->count == self->length)) {
+      self->pool = gmp_urandomb_ui(state, self->length);
+      self->count = 0;
+    }
+    size_t avail = self->length - self->count;
+    unsigned long z = ~self->pool & __DGS_LSB_BITMASK(avail);
+    if (__DGS_UNLIKELY(z == 0)) {
+      n += avail;
+      self->count = self->length;
+      continue;
+    }
+    size_t t = __builtin_ctzl(z);
+    self->pool = (t + 1 == (size_t)dgs_radix) ? 0 : self->pool >> (t + 1);
+    self->count += t + 1;
+    return n + t;
+  }
+}
+
 /**
    Sample a new uniformly random bit using libc ``random()``.
 
@@ -159,6 +280,91 @@ static inline unsigned long dgs_bern_uniform_call_libc(dgs_bern_uniform_t *self)
   return b;
 }
 
+/**
+   Sample a new uniformly random bit using a ``dgs_rng_t``.
+
+   :param self: Bernoulli state
+   :param rng: generator used as randomness source
+
+ */
+
+static inline unsigned long dgs_bern_uniform_call_rng(dgs_bern_uniform_t *self, dgs_rng_t *rng) {
+  assert(self != NULL);
+  if (__DGS_UNLIKELY(self->count == self->length)) {
+    self->pool = dgs_rng_randomb(rng, self->length);
+    self->count = 0;
+  }
+
+  unsigned long b = self->pool & 1;
+  self->pool >>= 1;
+  self->count++;
+  return b;
+}
+
+/**
+   Return ``k`` uniformly random bits at once, the bit ``dgs_bern_uniform_call_rng()``
+   would have returned first being the least significant one.
+
+   :param self: Bernoulli state
+   :param rng: generator used as randomness source
+   :param k: number of bits with ``k <= self->length``
+
+ */
+
+static inline unsigned long dgs_bern_uniform_bits_rng(dgs_bern_uniform_t *self, dgs_rng_t *rng, size_t k) {
+  assert(self != NULL);
+  assert(k <= self->length);
+  if (k == 0)
+    return 0;
+
+  unsigned long r = 0;
+  size_t got = self->length - self->count;
+  if (__DGS_UNLIKELY(got < k)) {
+    r = self->pool;
+    self->pool = dgs_rng_randomb(rng, self->length);
+    self->count = 0;
+  } else {
+    got = 0;
+  }
+
+  size_t need = k - got;
+  r |= (self->pool & __DGS_LSB_BITMASK(need)) << got;
+  self->pool = (need == (size_t)dgs_radix) ? 0 : self->pool >> need;
+  self->count += need;
+  return r;
+}
+
+/**
+   Consume uniformly random bits up to and including the first zero and return
+   the number of ones before it, found with one ``ctz`` per word of the pool.
+
+   :param self: Bernoulli state
+   :param rng: generator used as randomness source
+
+ */
+
+static inline unsigned long dgs_bern_uniform_ones_rng(dgs_bern_uniform_t *self, dgs_rng_t *rng) {
+  assert(self != NULL);
+  unsigned long n = 0;
+  while (1) {
+    if (__DGS_UNLIKELY(self->count == self->length)) {
+      self->pool = dgs_rng_randomb(rng, self->length);
+      self->count = 0;
+    }
+    size_t avail = self->length - self->count;
+    unsigned long z = ~self->pool & __DGS_LSB_BITMASK(avail);
+    if (__DGS_UNLIKELY(z == 0)) {
+      n += avail;
+      self->count = self->length;
+      continue;
+    }
+    size_t t = __builtin_ctzl(z);
+    self->pool = (t + 1 == (size_t)dgs_radix) ? 0 : self->pool >> (t + 1);
+    self->count += t + 1;
+    return n + t;
+  }
+}
+
 /**
    Clear cache of random bits.
 
@@ -254,14 +460,11 @@ dgs_bern_dp_t *dgs_bern_dp_init(double p);
    Return 1 with probability `p`.
 
    :param self: Bernoulli state
-
-  .. note::
-
-      Uses libc ``random()``.
+   :param rng: generator used as randomness source
 
  */
 
-long dgs_bern_dp_call(dgs_bern_dp_t *self);
+long dgs_bern_dp_call(dgs_bern_dp_t *self, dgs_rng_t *rng);
 
 /**
    Clear Bernoulli sampler.
@@ -295,6 +498,13 @@ typedef struct {
 
   dgs_bern_mp_t **B;
 
+  /**
+     ``p`` as fixed-point numbers if the precision of `f` is at most
+     ``DGS_MP_U128_MAX_PREC``, ``NULL`` otherwise. Calls then skip ``B``.
+  */
+
+  dgs_u128_t *p_u128;
+
 } dgs_bern_exp_mp_t;
 
 /**
@@ -334,26 +544,41 @@ void dgs_bern_exp_mp_clear(dgs_bern_exp_mp_t *self);
 
 /**
    double-precision Bernoulli distribution with `p = exp(-x/f)` for positive integers `x`.
+
+   `x` is split into digits of ``DGS_BERN_EXP_DP_DIGIT_BITS`` bits and
+   `exp(-x/f)` is the product of one tabulated probability per non-zero digit,
+   so ``x < DGS_BERN_EXP_DP_DIGIT_SIZE`` is a single lookup. The probabilities
+   are stored scaled to `2^64` and each comparison looks at 16 random bits
+   first, so one 64-bit word usually decides a whole call.
  */
 
 typedef struct {
   /**
-     We support positive `x` up to `2^l-1`
+     Bits of `x` below `l` are looked up in ``p``
    */
 
   size_t l;
 
   /**
-     Probabilities for Bernoulli sub-samplers.
+     `2^64·exp(-2^l/f)`, rounded down. The part of `x` at or above `2^l` costs
+     one trial with this probability per multiple of `2^l`, and returns 0
+     outright only if it is 0, i.e. `exp(-x/f) < 2^{-64}`.
    */
 
-  double *p;
+  uint64_t p_l;
 
   /**
-     Bernoulli sub-samplers.
-  */
+     Number of digits of `x`, i.e. `⌈l/DGS_BERN_EXP_DP_DIGIT_BITS⌉`.
+   */
 
-  dgs_bern_dp_t **B;
+  size_t digits;
+
+  /**
+     ``p[j*DGS_BERN_EXP_DP_DIGIT_SIZE + d]`` is `2^64·exp(-d·2^{jb}/f)` for
+     ``b = DGS_BERN_EXP_DP_DIGIT_BITS``, rounded down.
+   */
+
+  uint64_t *p;
 
 } dgs_bern_exp_dp_t;
 
@@ -361,7 +586,8 @@ typedef struct {
    Create new family of Bernoulli samplers.
 
    :param f: samplers return 1 with probability `exp(-x/f)`
-   :param l: we support inputs to call `x` up to `2^l-1`
+   :param l: inputs `x` up to `2^l-1` are tabulated, larger ones are slower
+             but still exact
 
    .. note::
 
@@ -375,12 +601,12 @@ dgs_bern_exp_dp_t* dgs_bern_exp_dp_init(double f, size_t l);
    Return 1 with probability `exp(-x/f)`.
 
    :param self: Bernoulli state
-   :param x: integer with `0 < x < 2^l`
-   :param state: GMP randstate used as randomness source
+   :param x: integer with `0 ≤ x`
+   :param rng: generator used as randomness source
 
  */
 
-long dgs_bern_exp_dp_call(dgs_bern_exp_dp_t *self, long x);
+long dgs_bern_exp_dp_call(dgs_bern_exp_dp_t *self, long x, dgs_rng_t *rng);
 
 /**
    Clear Bernoulli sampler family.
@@ -0,0 +1,153 @@
+/**
+   On-disk cache of precomputed sampler tables.
+
+   Building the tables of ``DGS_DISC_GAUSS_UNIFORM_TABLE``,
+   ``DGS_DISC_GAUSS_ALIAS``, ``DGS_DISC_GAUSS_CDT`` and
+   ``DGS_DISC_GAUSS_KNUTH_YAO`` costs one ``exp()`` (or ``mpfr_exp()``) per
+   entry. When the environment variable ``DGS_CACHE_DIR`` names a directory,
+   each table is written there once, keyed by the parameters it depends on
+   (algorithm, `σ`, `c`, `τ` and precision), and later samplers with the same
+   parameters map the file read-only instead of rebuilding it. All processes on
+   a machine then share one page-cache copy of each table.
+
+   A cache file is a ``dgs_cache_header_t`` followed by the table at offset
+   ``DGS_CACHE_HEADER_SIZE``. Files of another ``DGS_CACHE_VERSION``, written
+   on a machine of different endianness or word size, or whose key or size do
+   not match are ignored. Files are written to a temporary name and renamed into
+   place, so readers never see a partial table. Any failure to read or write the
+   cache silently falls back to building the table in memory.
+
+   TYPICAL USAGE::
+
+      dgs_cache_t cache = {0};
+      const double *rho = dgs_cache_load(&cache, key, size);
+      if (!rho) {
+        // build the table, then
+        dgs_cache_store(key, table, size);
+      }
+      dgs_cache_clear(&cache); // once the table is no longer used
+
+ */
+
+/******************************************************************************
+*
+*                      DGS - Discrete Gaussian Samplers
+*
+* Copyright (c) 2014, Martin Albrecht  <martinralbrecht+dgs@googlemail.com>
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are
+* those of the authors and should not be interpreted as representing official
+* policies, either expressed or implied, of the FreeBSD Project.
+******************************************************************************/
+
+#ifndef DGS_CACHE__H
+#define DGS_CACHE__H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+   Format version, bump whenever the layout of any cached table changes.
+*/
+
+#define DGS_CACHE_VERSION 1
+
+/**
+   Maximal length of a key, including the terminating zero.
+*/
+
+#define DGS_CACHE_KEY_SIZE 2048
+
+/**
+   Offset of the table in a cache file, one page so that the table is page
+   aligned in the mapping.
+*/
+
+#define DGS_CACHE_HEADER_SIZE 4096
+
+typedef struct {
+  char magic[8]; //< "DGSCACHE"
+  uint32_t version; //< ``DGS_CACHE_VERSION``
+  uint32_t endian; //< 0x01020304 as written by the producer
+  uint32_t long_size; //< ``sizeof(long)`` of the producer
+  uint32_t reserved;
+  uint64_t size; //< bytes of table following the header
+  char key[DGS_CACHE_KEY_SIZE]; //< parameters the table was built for
+} dgs_cache_header_t;
+
+/**
+   A read-only mapping of one cache file.
+*/
+
+typedef struct {
+  void *map; //< start of the mapping, ``NULL`` if nothing is mapped
+  size_t map_size; //< length of the mapping
+} dgs_cache_t;
+
+/**
+   Map the table stored under ``key`` if it exists and holds ``size`` bytes.
+
+   :param self: cache handle, must not hold a mapping yet.
+   :param key: parameters the table depends on, shorter than ``DGS_CACHE_KEY_SIZE``.
+   :param size: expected size of the table in bytes.
+
+   Returns a pointer to the read-only table, or ``NULL`` if caching is disabled
+   or no matching table was found.
+*/
+
+const void *dgs_cache_load(dgs_cache_t *self, const char *key, size_t size);
+
+/**
+   Store ``size`` bytes at ``data`` under ``key``, doing nothing if caching is
+   disabled or the file cannot be written.
+
+   :param key: parameters the table depends on, shorter than ``DGS_CACHE_KEY_SIZE``.
+   :param data: table.
+   :param size: size of the table in bytes.
+*/
+
+void dgs_cache_store(const char *key, const void *data, size_t size);
+
+/**
+   Return 1 if ``ptr`` points into the mapping held by ``self``, i.e. must not
+   be passed to ``free()``.
+
+   :param self: cache handle.
+   :param ptr: pointer to test.
+*/
+
+static inline int dgs_cache_contains(const dgs_cache_t *self, const void *ptr) {
+  uintptr_t p = (uintptr_t)ptr, m = (uintptr_t)self->map;
+  return self->map != NULL && p >= m && p < m + self->map_size;
+}
+
+/**
+   Unmap the table held by ``self``, if any.
+
+   :param self: cache handle.
+*/
+
+void dgs_cache_clear(dgs_cache_t *self);
+
+#endif //DGS_CACHE__H
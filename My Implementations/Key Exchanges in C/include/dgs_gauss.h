@@ -32,6 +32,18 @@
     adjusts sigma to match `σ₂·k` for some integer `k`.  Only integer-valued
     `c` are supported.
 
+  - ``DGS_DISC_GAUSS_CDT`` - a fixed-point cumulative distribution table is
+    precomputed and every sample is one uniform draw followed by a comparison
+    against every entry of the table. There is no rejection and no early exit,
+    so each sample costs the same and the scan vectorises. The cost is linear
+    in `τσ`, so this suits small `σ`. Any real-valued `c` is supported.
+
+  - ``DGS_DISC_GAUSS_KNUTH_YAO`` - the probabilities are written out in binary
+    as a matrix, one row per outcome and one column per bit, and samples are
+    drawn by walking the discrete distribution generating tree of that matrix
+    one random bit at a time. This uses close to the entropy of the
+    distribution in random bits. Any real-valued `c` is supported.
+
   AVAILABLE PRECISIONS:
 
   - ``mp`` - multi-precision using MPFR, cf. ``dgs_gauss_mp.c``
@@ -42,6 +54,11 @@
   with ``dgs_gauss_dp.c`` which implements the same algorithms as
   ``dgs_gauss_mp.c`` should be easier to read.
 
+  The tables of ``DGS_DISC_GAUSS_UNIFORM_TABLE`` (``dp`` only),
+  ``DGS_DISC_GAUSS_ALIAS``, ``DGS_DISC_GAUSS_CDT`` and
+  ``DGS_DISC_GAUSS_KNUTH_YAO`` are kept in an on-disk cache if
+  ``DGS_CACHE_DIR`` is set, cf. ``dgs_cache.h``.
+
   TYPICAL USAGE::
 
       dgs_disc_gauss_dp_t *D = dgs_disc_gauss_dp_init(<sigma>, <c>, <tau>, <algorithm>);
@@ -88,6 +105,7 @@
 #define DGS_GAUSS__H
 
 #include "dgs_bern.h"
+#include "dgs_cache.h"
 
 /** UTILITY FUNCTIONS **/
 
@@ -124,14 +142,35 @@ typedef enum {
   DGS_DISC_GAUSS_UNIFORM_LOGTABLE  = 0x3, //<call dgs_disc_gauss_mp_call_uniform_logtable
   DGS_DISC_GAUSS_SIGMA2_LOGTABLE   = 0x7, //<call dgs_disc_gauss_mp_call_sigma2_logtable
   DGS_DISC_GAUSS_ALIAS             = 0x8, //<call dgs_disc_gauss_mp_call_alias
+  DGS_DISC_GAUSS_CDT               = 0x9, //<call dgs_disc_gauss_mp_call_cdt
+  DGS_DISC_GAUSS_KNUTH_YAO         = 0xa, //<call dgs_disc_gauss_mp_call_knuth_yao
 } dgs_disc_gauss_alg_t;
 
+/**
+   One bucket of an alias table.
+
+   A 64-bit random word picks the bucket with its top bits and keeps it if the
+   remaining bits, read as a fraction of `2^64`, are below ``threshold``.
+   Otherwise it returns ``alias``.
+*/
+
+typedef struct {
+  uint64_t threshold; //< probability of keeping the bucket, scaled to `2^64`
+  int32_t alias;      //< index returned otherwise
+} dgs_disc_gauss_alias_t;
+
 /**
    Maximal permitted tablesize if DGS_DISC_GAUSS_DEFAULT is chosen.
 */
 
 #define DGS_DISC_GAUSS_MAX_TABLE_SIZE_BYTES (1<<16)
 
+/**
+   Number of samples produced per round by the ``*_call_n`` functions.
+*/
+
+#define DGS_DISC_GAUSS_BATCH 256
+
 /**
    Discrete Gaussian `D_{σ₂,0}` with `σ₂ := sqrt(1/(2·log(2)))`.
 
@@ -168,13 +207,12 @@ void dgs_disc_gauss_sigma2p_mp_call(mpz_t rop, dgs_disc_gauss_sigma2p_t *self, g
 /**
    Return a ``long`` sampled from `D_{σ₂,0}`.
 
-   :param rop: target value.
    :param self: discrete Gaussian sampler.
-   :param state: entropy pool.
+   :param rng: entropy pool.
 
 */
 
-long dgs_disc_gauss_sigma2p_dp_call(dgs_disc_gauss_sigma2p_t *self);
+long dgs_disc_gauss_sigma2p_dp_call(dgs_disc_gauss_sigma2p_t *self, dgs_rng_t *rng);
 
 /**
    Free `D_{σ₂,0}` sampler.
@@ -226,6 +264,13 @@ typedef struct _dgs_disc_gauss_dp_t {
 
   dgs_disc_gauss_alg_t algorithm;  //<  which algorithm to use
 
+  /**
+     All randomness is drawn from this generator, see ``dgs_disc_gauss_dp_set_rng()``.
+   */
+
+  dgs_rng_t *rng;
+  int rng_owned; //< whether ``rng`` is freed with the sampler
+
   /**
      We use a uniform Bernoulli to decide signs.
    */
@@ -306,11 +351,41 @@ typedef struct _dgs_disc_gauss_dp_t {
   double *rho;
   
   /**
-   * Tables required for alias sampling.
+     Alias table of ``DGS_DISC_GAUSS_ALIAS`` with ``2^alias_bits`` buckets, one
+     per value of ``-upper_bound+1,...,upper_bound-1`` and the rest empty.
    */
-   
-  long* alias;
-  dgs_bern_dp_t** bias;
+
+  dgs_disc_gauss_alias_t *alias;
+  int alias_bits;
+
+  /**
+     Cumulative probabilities scaled to `2^63` in ``DGS_DISC_GAUSS_CDT``, entry
+     ``i`` is the probability of the first ``i+1`` outcomes. If `c` is an
+     integer the table covers ``0,...,upper_bound-1`` with `ρ(0)` halved and a
+     sign is drawn, otherwise it covers the whole range.
+  */
+
+  int64_t *cdt;
+  long cdt_size; //< number of entries in ``cdt``
+
+  /**
+     Probability matrix of ``DGS_DISC_GAUSS_KNUTH_YAO``, stored by column: bit
+     ``j`` of the probability of outcome ``i`` is bit ``i%64`` of
+     ``ky[j*ky_words + i/64]``. Outcomes are laid out as in ``cdt``.
+  */
+
+  uint64_t *ky;
+  long *ky_weight; //< number of ones in each column of ``ky``
+  long ky_words; //< words per column of ``ky``
+  long ky_cols; //< columns of ``ky``, i.e. bits of precision
+
+  /**
+     Mapping of the on-disk table cache, see ``dgs_cache.h``. Tables pointing
+     into it are read-only and are not freed with the sampler.
+  */
+
+  dgs_cache_t cache;
+  int nocache; //< skip the on-disk cache, see ``dgs_disc_gauss_dp_init_nocache()``
 } dgs_disc_gauss_dp_t;
 
 /**
@@ -321,10 +396,42 @@ typedef struct _dgs_disc_gauss_dp_t {
  :param tau: cutoff `τ`
  :param algorithm: algorithm to use.
 
+ .. note::
+
+     The sampler gets its own ``DGS_RNG_DEFAULT`` generator seeded from
+     ``/dev/urandom``, replace it with ``dgs_disc_gauss_dp_set_rng()``.
+
 */
 
 dgs_disc_gauss_dp_t *dgs_disc_gauss_dp_init(double sigma, double c, size_t tau, dgs_disc_gauss_alg_t algorithm);
 
+/**
+ As ``dgs_disc_gauss_dp_init()`` but never reading or writing the on-disk
+ cache, for short-lived samplers whose tables are not worth a file.
+
+ :param sigma: width parameter `σ`
+ :param c: center `c`
+ :param tau: cutoff `τ`
+ :param algorithm: algorithm to use.
+
+*/
+
+dgs_disc_gauss_dp_t *dgs_disc_gauss_dp_init_nocache(double sigma, double c, size_t tau, dgs_disc_gauss_alg_t algorithm);
+
+/**
+ Draw randomness from ``rng`` from now on.
+
+ :param self: discrete Gaussian sampler
+ :param rng: generator, which stays owned by the caller and must outlive the sampler
+
+ .. note::
+
+     Samplers sharing a generator must not be called concurrently.
+
+*/
+
+void dgs_disc_gauss_dp_set_rng(dgs_disc_gauss_dp_t *self, dgs_rng_t *rng);
+
 /**
    Sample from ``dgs_disc_gauss_dp_t`` by rejection sampling using the uniform distribution
 
@@ -362,14 +469,57 @@ long dgs_disc_gauss_dp_call_uniform_table(dgs_disc_gauss_dp_t *self);
 long dgs_disc_gauss_dp_call_uniform_table_offset(dgs_disc_gauss_dp_t *self);
 
 /**
-   Sample from ``dgs_disc_gauss_dp_t`` by alias sampling. This is extremely fast, 
-   but requires more resources and setup cost is around (2τσ)².
+   Sample from ``dgs_disc_gauss_dp_t`` by alias sampling. This is extremely fast,
+   one random word and one bucket per sample. The table is built in time linear
+   in `2τσ` with Vose's method.
 
    :param self: discrete Gaussian sampler
  */
 
 long dgs_disc_gauss_dp_call_alias(dgs_disc_gauss_dp_t *self);
 
+/**
+   Sample from ``dgs_disc_gauss_dp_t`` by inversion of a cumulative distribution
+   table. Each call draws one 64-bit word and scans the whole table.
+
+   :param self: discrete Gaussian sampler
+
+   .. note::
+
+      `c` must be an integer in this algorithm
+ */
+
+long dgs_disc_gauss_dp_call_cdt(dgs_disc_gauss_dp_t *self);
+
+/**
+   As ``dgs_disc_gauss_dp_call_cdt()`` for any `c`, with a table twice as long.
+
+   :param self: discrete Gaussian sampler
+ */
+
+long dgs_disc_gauss_dp_call_cdt_offset(dgs_disc_gauss_dp_t *self);
+
+/**
+   Sample from ``dgs_disc_gauss_dp_t`` with the Knuth-Yao algorithm, taking
+   random bits from ``self->B``.
+
+   :param self: discrete Gaussian sampler
+
+   .. note::
+
+      `c` must be an integer in this algorithm
+ */
+
+long dgs_disc_gauss_dp_call_knuth_yao(dgs_disc_gauss_dp_t *self);
+
+/**
+   As ``dgs_disc_gauss_dp_call_knuth_yao()`` for any `c`, with a matrix twice as tall.
+
+   :param self: discrete Gaussian sampler
+ */
+
+long dgs_disc_gauss_dp_call_knuth_yao_offset(dgs_disc_gauss_dp_t *self);
+
 /**
   Sample from ``dgs_disc_gauss_dp_t`` by rejection sampling using the uniform
   distribution replacing all ``exp()`` calls with calls to Bernoulli
@@ -399,6 +549,33 @@ long dgs_disc_gauss_dp_call_uniform_logtable(dgs_disc_gauss_dp_t *self);
 
 long dgs_disc_gauss_dp_call_sigma2_logtable(dgs_disc_gauss_dp_t *self);
 
+/**
+   Fill ``out`` with ``n`` samples from ``self``.
+
+   The algorithm is dispatched once per call instead of once per sample, and
+   ``DGS_DISC_GAUSS_UNIFORM_TABLE`` draws its candidates, table lookups and
+   signs in rounds of ``DGS_DISC_GAUSS_BATCH`` with branch free inner loops.
+
+   :param self: discrete Gaussian sampler
+   :param out: ``n`` samples are written here
+   :param n: number of samples
+
+ */
+
+void dgs_disc_gauss_dp_call_n(dgs_disc_gauss_dp_t *self, long *out, size_t n);
+
+/**
+   As ``dgs_disc_gauss_dp_call_n()`` writing ``int32_t``, samples must fit.
+ */
+
+void dgs_disc_gauss_dp_call_n_int32(dgs_disc_gauss_dp_t *self, int32_t *out, size_t n);
+
+/**
+   As ``dgs_disc_gauss_dp_call_n()`` writing ``int16_t``, samples must fit.
+ */
+
+void dgs_disc_gauss_dp_call_n_int16(dgs_disc_gauss_dp_t *self, int16_t *out, size_t n);
+
 /**
    The uniform Bernoulli sampler which is used to decide signs caches bits for
    performance reasons. This functions clears this cache of random bits.
@@ -546,13 +723,50 @@ typedef struct _dgs_disc_gauss_mp_t {
   */
 
   mpfr_t *rho;
+
+  /**
+     ``rho`` scaled to `2^128`, replacing it if the precision is at most
+     ``DGS_MP_U128_MAX_PREC``.
+  */
+
+  dgs_u128_t *rho_u128;
   
-    /**
-   * Tables required for alias sampling.
+  /**
+     Alias table of ``DGS_DISC_GAUSS_ALIAS``, laid out as
+     ``dgs_disc_gauss_dp_t.alias``. It is computed at the precision of `σ`, but
+     the thresholds are stored with 64 bits.
    */
-   
-  mpz_t* alias;
-  dgs_bern_mp_t** bias;
+
+  dgs_disc_gauss_alias_t *alias;
+  int alias_bits;
+
+  /**
+     Cumulative probabilities in ``DGS_DISC_GAUSS_CDT`` as fixed-point numbers
+     of ``cdt_limbs`` limbs each, stored one after the other. The layout of the
+     table matches ``dgs_disc_gauss_dp_t.cdt``.
+  */
+
+  mp_limb_t *cdt;
+  long cdt_size; //< number of entries in ``cdt``
+  mp_size_t cdt_limbs; //< limbs per entry, covering the precision of `σ`
+  mp_limb_t *cdt_tmp; //< space for one uniform entry and one difference
+
+  /**
+     Probability matrix of ``DGS_DISC_GAUSS_KNUTH_YAO`` with as many columns as
+     the precision of `σ`, laid out as ``dgs_disc_gauss_dp_t.ky``.
+  */
+
+  uint64_t *ky;
+  long *ky_weight; //< number of ones in each column of ``ky``
+  long ky_words; //< words per column of ``ky``
+  long ky_cols; //< columns of ``ky``, i.e. bits of precision
+
+  /**
+     Mapping of the on-disk table cache, see ``dgs_cache.h``. Tables pointing
+     into it are read-only and are not freed with the sampler.
+  */
+
+  dgs_cache_t cache;
 
 } dgs_disc_gauss_mp_t;
 
@@ -588,13 +802,80 @@ void dgs_disc_gauss_mp_call_uniform_table(mpz_t rop, dgs_disc_gauss_mp_t *self,
 void dgs_disc_gauss_mp_call_uniform_table_offset(mpz_t rop, dgs_disc_gauss_mp_t *self, gmp_randstate_t state);
 
 /**
-   Sample from ``dgs_disc_gauss_mp_t`` by alias sampling. This is extremely fast, 
-   but requires more resources and setup cost is around (2τσ)².
+   As ``dgs_disc_gauss_mp_call_uniform_table()``, but comparing against
+   ``rho_u128`` with ``dgs_bern_u128_call()``. Used instead of it when the
+   precision is at most ``DGS_MP_U128_MAX_PREC``.
+
+   :param self: discrete Gaussian sampler
+
+ */
+
+void dgs_disc_gauss_mp_call_uniform_table_u128(mpz_t rop, dgs_disc_gauss_mp_t *self, gmp_randstate_t state);
+
+/**
+   As ``dgs_disc_gauss_mp_call_uniform_table_offset()``, but comparing against
+   ``rho_u128`` with ``dgs_bern_u128_call()``. Used instead of it when the
+   precision is at most ``DGS_MP_U128_MAX_PREC``.
+
+   :param self: discrete Gaussian sampler
+
+ */
+
+void dgs_disc_gauss_mp_call_uniform_table_offset_u128(mpz_t rop, dgs_disc_gauss_mp_t *self, gmp_randstate_t state);
+
+/**
+   Sample from ``dgs_disc_gauss_mp_t`` by alias sampling. This is extremely fast,
+   one random word and one bucket per sample. The table is built in time linear
+   in `2τσ` with Vose's method.
 
    :param self: discrete Gaussian sampler
  */
 void dgs_disc_gauss_mp_call_alias(mpz_t rop, dgs_disc_gauss_mp_t *self, gmp_randstate_t state);
 
+/**
+   Sample from ``dgs_disc_gauss_mp_t`` by inversion of a cumulative distribution
+   table. Each entry is compared with ``mpn_sub_n()``, or as one integer if it
+   fits 128 bits. Neither stops early, so every call does the same amount of
+   work.
+
+   :param self: discrete Gaussian sampler
+
+   .. note::
+
+      `c` must be an integer in this algorithm
+ */
+
+void dgs_disc_gauss_mp_call_cdt(mpz_t rop, dgs_disc_gauss_mp_t *self, gmp_randstate_t state);
+
+/**
+   As ``dgs_disc_gauss_mp_call_cdt()`` for any `c`, with a table twice as long.
+
+   :param self: discrete Gaussian sampler
+ */
+
+void dgs_disc_gauss_mp_call_cdt_offset(mpz_t rop, dgs_disc_gauss_mp_t *self, gmp_randstate_t state);
+
+/**
+   Sample from ``dgs_disc_gauss_mp_t`` with the Knuth-Yao algorithm, taking
+   random bits from ``self->B``.
+
+   :param self: discrete Gaussian sampler
+
+   .. note::
+
+      `c` must be an integer in this algorithm
+ */
+
+void dgs_disc_gauss_mp_call_knuth_yao(mpz_t rop, dgs_disc_gauss_mp_t *self, gmp_randstate_t state);
+
+/**
+   As ``dgs_disc_gauss_mp_call_knuth_yao()`` for any `c`, with a matrix twice as tall.
+
+   :param self: discrete Gaussian sampler
+ */
+
+void dgs_disc_gauss_mp_call_knuth_yao_offset(mpz_t rop, dgs_disc_gauss_mp_t *self, gmp_randstate_t state);
+
 /**
   Sample from ``dgs_disc_gauss_mp_t`` by rejection sampling using the uniform
   distribution replacing all ``exp()`` calls with call to Bernoulli distributions.
@@ -630,6 +911,30 @@ void dgs_disc_gauss_mp_call_uniform_online(mpz_t rop, dgs_disc_gauss_mp_t *self,
 
 void dgs_disc_gauss_mp_call_sigma2_logtable(mpz_t rop, dgs_disc_gauss_mp_t *self, gmp_randstate_t state);
 
+/**
+   Fill ``out`` with ``n`` samples from ``self``, which must fit into a ``long``.
+
+   :param self: discrete Gaussian sampler
+   :param out: ``n`` samples are written here
+   :param n: number of samples
+   :param state: entropy pool
+
+ */
+
+void dgs_disc_gauss_mp_call_n(dgs_disc_gauss_mp_t *self, long *out, size_t n, gmp_randstate_t state);
+
+/**
+   As ``dgs_disc_gauss_mp_call_n()`` writing ``int32_t``, samples must fit.
+ */
+
+void dgs_disc_gauss_mp_call_n_int32(dgs_disc_gauss_mp_t *self, int32_t *out, size_t n, gmp_randstate_t state);
+
+/**
+   As ``dgs_disc_gauss_mp_call_n()`` writing ``int16_t``, samples must fit.
+ */
+
+void dgs_disc_gauss_mp_call_n_int16(dgs_disc_gauss_mp_t *self, int16_t *out, size_t n, gmp_randstate_t state);
+
 /**
    Clear cache of random bits.
 
@@ -0,0 +1,226 @@
+/**
+   Per-sampler pseudorandom number generators.
+
+   Every double-precision sampler owns a ``dgs_rng_t`` and draws all of its
+   randomness from it, so samplers running on different threads never touch
+   shared state. Words are produced in blocks of ``DGS_RNG_BUFFER_WORDS`` by a
+   backend specific refill function and handed out from that buffer.
+
+   Available backends:
+
+   - ``DGS_RNG_XOSHIRO256SS`` - xoshiro256** by Blackman and Vigna, fast but not
+     cryptographically secure.
+
+   - ``DGS_RNG_CHACHA20`` - the ChaCha20 stream cipher (RFC 7539) keyed with the
+     seed, for when samples must be unpredictable.
+
+   - ``DGS_RNG_LIBC`` - libc ``random()``, the historic behaviour. Process-global
+     and lock-protected, only useful for comparisons.
+
+   Any other generator (e.g. an AES-CTR DRBG) plugs in by providing a refill
+   function filling ``buf``.
+
+   TYPICAL USAGE::
+
+      dgs_rng_t *rng = dgs_rng_init(DGS_RNG_DEFAULT, NULL, 0);
+      dgs_rng_uniform_u64(rng); // as often as needed
+      dgs_rng_clear(rng);
+
+ */
+
+/******************************************************************************
+*
+*                      DGS - Discrete Gaussian Samplers
+*
+* Copyright (c) 2014, Martin Albrecht  <martinralbrecht+dgs@googlemail.com>
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are
+* those of the authors and should not be interpreted as representing official
+* policies, either expressed or implied, of the FreeBSD Project.
+******************************************************************************/
+
+#ifndef DGS_RNG__H
+#define DGS_RNG__H
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+   Number of 64-bit words produced per refill.
+*/
+
+#define DGS_RNG_BUFFER_WORDS 64
+
+/**
+   Number of seed bytes read from ``/dev/urandom`` when no seed is given.
+*/
+
+#define DGS_RNG_SEED_BYTES 32
+
+/**
+   Available backends
+*/
+
+typedef enum {
+  DGS_RNG_DEFAULT       = 0x0, //<pick backend (xoshiro256**)
+  DGS_RNG_XOSHIRO256SS  = 0x1, //<xoshiro256**
+  DGS_RNG_CHACHA20      = 0x2, //<ChaCha20 keystream
+  DGS_RNG_LIBC          = 0x3, //<libc random()
+} dgs_rng_alg_t;
+
+typedef struct _dgs_rng_t {
+
+  dgs_rng_alg_t algorithm; //<  which backend to use
+
+  /**
+     Buffered output, ``buf[pos]`` is the next word handed out.
+  */
+
+  uint64_t buf[DGS_RNG_BUFFER_WORDS];
+  size_t pos;
+
+  /**
+     Fill ``buf`` with ``DGS_RNG_BUFFER_WORDS`` fresh words.
+  */
+
+  void (*refill)(struct _dgs_rng_t *self);
+
+  /**
+     Backend state.
+  */
+
+  union {
+    uint64_t xoshiro[4];
+    struct {
+      uint32_t key[8];
+      uint64_t counter;
+    } chacha;
+  } state;
+
+} dgs_rng_t;
+
+/**
+   Create a new generator.
+
+   :param algorithm: backend to use.
+   :param seed: seed bytes, or ``NULL`` to seed from ``/dev/urandom``.
+   :param seedlen: number of seed bytes.
+
+   .. note::
+
+       Clear with ``dgs_rng_clear()``.
+
+*/
+
+dgs_rng_t *dgs_rng_init(dgs_rng_alg_t algorithm, const uint8_t *seed, size_t seedlen);
+
+/**
+   Return 64 uniformly random bits.
+
+   :param self: generator
+
+*/
+
+static inline uint64_t dgs_rng_uniform_u64(dgs_rng_t *self) {
+  assert(self != NULL);
+  if (__builtin_expect(self->pos == DGS_RNG_BUFFER_WORDS, 0)) {
+    self->refill(self);
+    self->pos = 0;
+  }
+  return self->buf[self->pos++];
+}
+
+/**
+   Return a uniformly random double in `[0,1)` with 53 bits of randomness.
+
+   :param self: generator
+
+*/
+
+static inline double dgs_rng_uniform_double(dgs_rng_t *self) {
+  return (double)(dgs_rng_uniform_u64(self) >> 11) * (1.0/9007199254740992.0);
+}
+
+/**
+   Return ``nbits`` uniformly random bits, ``0 < nbits <= 64``.
+
+   :param self: generator
+   :param nbits: number of bits
+
+*/
+
+static inline unsigned long dgs_rng_randomb(dgs_rng_t *self, size_t nbits) {
+  assert(nbits > 0 && nbits <= 64);
+  return (unsigned long)(dgs_rng_uniform_u64(self) >> (64 - nbits));
+}
+
+/**
+   Return a uniformly random integer in `[0,n)` for any ``n > 0``.
+
+   This is Lemire's multiply-shift method: the high word of a 64x64-bit
+   product is the sample, and only draws whose low word falls below
+   `2^64 mod n` are rejected, so the common path has no division.
+
+   :param self: generator
+   :param n: bound
+
+*/
+
+static inline uint64_t dgs_rng_uniform(dgs_rng_t *self, uint64_t n) {
+  assert(n > 0);
+  unsigned __int128 m = (unsigned __int128)dgs_rng_uniform_u64(self) * n;
+  uint64_t l = (uint64_t)m;
+  if (__builtin_expect(l < n, 0)) {
+    uint64_t t = (0 - n) % n;
+    while (l < t) {
+      m = (unsigned __int128)dgs_rng_uniform_u64(self) * n;
+      l = (uint64_t)m;
+    }
+  }
+  return (uint64_t)(m >> 64);
+}
+
+/**
+   Return a uniformly random integer in `[0,n)`, ``n > 0``, see ``dgs_rng_uniform()``.
+
+   :param self: generator
+   :param n: bound
+
+*/
+
+static inline unsigned long dgs_rng_randomm(dgs_rng_t *self, unsigned long n) {
+  return (unsigned long)dgs_rng_uniform(self, n);
+}
+
+/**
+   Free memory.
+
+   :param self: generator
+
+*/
+
+void dgs_rng_clear(dgs_rng_t *self);
+
+#endif //DGS_RNG__H
@@ -21,6 +21,22 @@
  - ``DGS_RROUND_KARNEY`` - Use Karney's algorithm. This is better than 
    uniform rejection sampling.
 
+ - ``DGS_RROUND_KARNEY_EXACT`` - Karney's algorithm with every Bernoulli trial
+   done exactly: `exp(-1/2)` and the final `exp(-x(2k+x)/2)` are decided by von
+   Neumann's method, comparing uniform deviates whose bits are drawn 64 at a
+   time only as far as needed. No ``exp()`` or other libm function is called
+   per sample.
+
+ - ``DGS_RROUND_TABLE_CACHE`` - keep ``DGS_DISC_GAUSS_ALIAS`` samplers of
+   `D_{σ,c}` for the ``DGS_RROUND_CACHE_SIZE`` most recently used pairs
+   `(σ, c mod 1)`. A pair is tabulated the second time it is seen, until then
+   and for tables above ``DGS_DISC_GAUSS_MAX_TABLE_SIZE_BYTES`` Karney's
+   algorithm is used. Per ``DGS_RROUND_CACHE_WINDOW`` calls only one table is
+   built for each ``DGS_RROUND_CACHE_HITS_PER_BUILD`` calls the tables served
+   in the previous window, so many distinct parameters degrade to Karney's
+   algorithm rather than to rebuilding tables. This pays off when few distinct
+   parameters recur often, dp only.
+
   AVAILABLE PRECISIONS:
 
   - ``mp`` - multi-precision using MPFR, cf. ``dgs_gauss_mp.c``
@@ -35,6 +51,7 @@
 
       dgs_rround_dp_t *D = dgs_rround_dp_init(<tau>, <algorithm>);
       D->call(D, <sigma>, <c>); // as often as needed
+      dgs_rround_dp_call_karney_n(D, <sigma>, <centers>, <out>, <n>); // one sample per center
       dgs_rround_dp_clear(D);
 
    .. author:: Michael Walter
@@ -54,8 +71,61 @@ typedef enum {
   DGS_RROUND_DEFAULT           = 0x0, //<pick algorithm
   DGS_RROUND_UNIFORM_ONLINE    = 0x1, //<call dgs_disc_gauss_mp_call_uniform_online
   DGS_RROUND_KARNEY            = 0x2, //<call dgs_disc_gauss_mp_call_karney
+  DGS_RROUND_KARNEY_EXACT      = 0x3, //<call dgs_disc_gauss_mp_call_karney_exact
+  DGS_RROUND_TABLE_CACHE       = 0x4, //<call dgs_rround_dp_call_table_cache
 } dgs_rround_alg_t;
 
+/**
+   ``DGS_RROUND_KARNEY_EXACT`` keeps this many 64-bit words of a uniform
+   deviate. Deviates agreeing on all of them, which happens with probability
+   `2^{-256}`, are compared on fresh bits.
+*/
+
+#define DGS_RROUND_KARNEY_WORDS 4
+
+/**
+   Number of values `k = 0,1,...` of the unit Gaussian `D_{\ZZ⁺,1}` tabulated for
+   ``dgs_rround_dp_call_karney_n()``, larger values have probability below
+   `2^{-64}`.
+*/
+
+#define DGS_RROUND_KARNEY_CDT_SIZE 10
+
+/**
+   Number of samplers kept by ``DGS_RROUND_TABLE_CACHE``.
+*/
+
+#define DGS_RROUND_CACHE_SIZE 16
+
+/**
+   ``DGS_RROUND_TABLE_CACHE`` sets a budget of tables to build every this many
+   calls.
+*/
+
+#define DGS_RROUND_CACHE_WINDOW 4096
+
+/**
+   ``DGS_RROUND_TABLE_CACHE`` may build one table per window for this many
+   calls served by a table in the previous window, and at least one. A table
+   costs about as much as this many samples save.
+*/
+
+#define DGS_RROUND_CACHE_HITS_PER_BUILD 512
+
+/**
+   ``DGS_RROUND_TABLE_CACHE`` rounds `σ` and `c mod 1` to multiples of
+   `2^{-DGS_RROUND_CACHE_QUANTUM_BITS}` to look up a sampler. Samples taken
+   from the table are from `D_{σ',c'}` with `|σ-σ'|, |c-c'| ≤ 2^{-33}`.
+*/
+
+#define DGS_RROUND_CACHE_QUANTUM_BITS 32
+
+typedef struct {
+  double sigma; //< quantised `σ`
+  double c_r;   //< quantised `c mod 1`
+  dgs_disc_gauss_dp_t *D; //< sampler of `D_{σ,c_r}`, NULL in ``seen``
+} dgs_rround_dp_cache_entry_t;
+
 struct _dgs_rround_mp_t;
 
 typedef struct _dgs_rround_dp_t {
@@ -68,9 +138,43 @@ typedef struct _dgs_rround_dp_t {
 
   size_t tau;
 
+  /**
+     All randomness is drawn from this generator, see ``dgs_rround_dp_set_rng()``.
+   */
+
+  dgs_rng_t *rng;
+  int rng_owned; //< whether ``rng`` is freed with the rounder
+
   dgs_bern_uniform_t *B;
   dgs_bern_dp_t *B_half_exp;
 
+  /**
+     Probabilities of `0,...,k` under `D_{\ZZ⁺,1}`, i.e. proportional to
+     `exp(-k²/2)`, scaled to `2^64`. Used by ``dgs_rround_dp_call_karney_n()``
+     in place of ``B_half_exp``.
+  */
+
+  uint64_t karney_cdt[DGS_RROUND_KARNEY_CDT_SIZE - 1];
+
+  /**
+     Samplers of ``DGS_RROUND_TABLE_CACHE``, most recently used first.
+  */
+
+  dgs_rround_dp_cache_entry_t cache[DGS_RROUND_CACHE_SIZE];
+  size_t cache_used;
+
+  /**
+     Pairs of ``DGS_RROUND_TABLE_CACHE`` seen once and not tabulated yet, a
+     ring overwritten from ``seen_next`` on. Empty slots have `σ = 0`.
+  */
+
+  dgs_rround_dp_cache_entry_t seen[DGS_RROUND_CACHE_SIZE];
+  size_t seen_next;
+
+  size_t cache_calls;  //< calls in the current ``DGS_RROUND_CACHE_WINDOW``
+  size_t cache_hits;   //< calls served by a table in the current window
+  size_t cache_budget; //< tables that may still be built in the current window
+
   dgs_rround_alg_t algorithm;  //<  which algorithm to use
 
   /**
@@ -96,6 +200,16 @@ typedef struct _dgs_rround_dp_t {
 
 dgs_rround_dp_t *dgs_rround_dp_init(size_t tau, dgs_rround_alg_t algorithm);
 
+/**
+ Draw randomness from ``rng`` from now on.
+
+ :param self: discrete Gaussian rounder
+ :param rng: generator, which stays owned by the caller and must outlive the rounder
+
+*/
+
+void dgs_rround_dp_set_rng(dgs_rround_dp_t *self, dgs_rng_t *rng);
+
 /**
    Sample from ``dgs_rround_dp_t`` by rejection sampling using the uniform distribution
 
@@ -115,6 +229,47 @@ long dgs_rround_dp_call_uniform_online(dgs_rround_dp_t *self, double sigma, doub
  */
 long dgs_rround_dp_call_karney(dgs_rround_dp_t *self, double sigma, double c);
 
+/**
+   Sample from ``dgs_rround_dp_t`` using Karney's algorithm with exact
+   Bernoulli trials, see ``DGS_RROUND_KARNEY_EXACT``.
+
+   :param self: discrete Gaussian rounder
+   :param sigma: noise parameter
+   :param c: center
+ */
+
+long dgs_rround_dp_call_karney_exact(dgs_rround_dp_t *self, double sigma, double c);
+
+/**
+   Sample from ``dgs_rround_dp_t`` using a cached alias sampler for `(σ, c mod
+   1)` if there is one and Karney's algorithm otherwise, see
+   ``DGS_RROUND_TABLE_CACHE``.
+
+   :param self: discrete Gaussian rounder
+   :param sigma: noise parameter
+   :param c: center
+ */
+
+long dgs_rround_dp_call_table_cache(dgs_rround_dp_t *self, double sigma, double c);
+
+/**
+   Write one sample of `D_{σ,c_i}` to ``out[i]`` for each of the ``n`` centers,
+   using Karney's algorithm as ``dgs_rround_dp_call_karney()``.
+
+   Everything depending on `σ` is computed once per call. Candidates are drawn
+   ``DGS_DISC_GAUSS_BATCH`` at a time, the unit Gaussian part by inversion of
+   ``karney_cdt``, and accepted or rejected in one pass without branches.
+   Rejected centers are retried in the next round.
+
+   :param self: discrete Gaussian rounder, created with ``DGS_RROUND_KARNEY``
+   :param sigma: noise parameter
+   :param centers: ``n`` centers
+   :param out: ``n`` samples
+   :param n: number of samples
+*/
+
+void dgs_rround_dp_call_karney_n(dgs_rround_dp_t *self, double sigma, const double *centers, long *out, size_t n);
+
 /**
    Free memory.
 
@@ -230,6 +385,20 @@ void dgs_rround_mp_call_uniform_online(mpz_t rop, dgs_rround_mp_t *self, const m
 
 void dgs_rround_mp_call_karney(mpz_t rop, dgs_rround_mp_t *self, const mpfr_t sigma, const mpfr_t c, gmp_randstate_t state);
 
+/**
+  Sample from ``dgs_rround_mp_t`` using Karney's algorithm with exact
+  Bernoulli trials, see ``DGS_RROUND_KARNEY_EXACT``.
+
+  :param rop: return value
+  :param self: discrete Gaussian rounder
+  :param sigma: noise parameter
+  :param c: center
+  :param state: state
+
+ */
+
+void dgs_rround_mp_call_karney_exact(mpz_t rop, dgs_rround_mp_t *self, const mpfr_t sigma, const mpfr_t c, gmp_randstate_t state);
+
 
 /**
    Free memory.
@@ -0,0 +1,44 @@
+/********************************************************************************************
+ * A simple provably secure key exchange based on the learning with errors problem
+ *
+ *
+ * Based on the paper:
+ *     Jintai Ding, Xiang Xie and Xiaodong Ling
+ *
+ * Copyright (c) Jintai Ding, Xiang Xie and Xiaodong Ling for the theoretical key exchange
+ *               Afraz Arif Khan for implementing the key exchange in C and TLS
+ *
+ * Released under the MIT License; see LICENSE.txt for details.
+ ********************************************************************************************/
+
+/** \file fips202.h
+ * SHAKE128 extendable output function (FIPS 202), following the public domain
+ * Keccak reference code
+ */
+
+#ifndef HEADER_FIPS202_H
+#define HEADER_FIPS202_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SHAKE128_RATE 168 // Bytes squeezed per Keccak-f[1600] permutation
+
+typedef struct {
+  uint64_t s[25];
+} shake128_state;
+
+/*------------------------------Function Prototypes---------------------------*/
+
+// Absorb the whole input (and the SHAKE padding) into a fresh state
+extern void shake128_absorb(shake128_state *state, const uint8_t *in, size_t inlen);
+
+// Squeeze nblocks blocks of SHAKE128_RATE bytes
+extern void shake128_squeezeblocks(uint8_t *out, size_t nblocks, shake128_state *state);
+
+// One shot SHAKE128 of outlen bytes
+extern void shake128(uint8_t *out, size_t outlen, const uint8_t *in, size_t inlen);
+
+/*---------------------------End of Function Prototypes-----------------------*/
+
+#endif
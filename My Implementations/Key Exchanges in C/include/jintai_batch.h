@@ -0,0 +1,54 @@
+/********************************************************************************************
+ * A simple provably secure key exchange based on the learning with errors problem
+ *
+ *
+ * Based on the paper:
+ *     Jintai Ding, Xiang Xie and Xiaodong Ling
+ *
+ * Copyright (c) Jintai Ding, Xiang Xie and Xiaodong Ling for the theoretical key exchange
+ *               Afraz Arif Khan for implementing the key exchange in C and TLS
+ *
+ * Released under the MIT License; see LICENSE.txt for details.
+ ********************************************************************************************/
+
+/** \file jintai_batch.h
+ * Many independent key exchanges on a pool of pinned worker threads
+ */
+
+#ifndef HEADER_JINTAI_BATCH_H
+#define HEADER_JINTAI_BATCH_H
+
+#include <stddef.h>
+
+#include "jintailwe.h"
+
+/*
+ jintai_run_batch() starts one worker thread per context in ctx_array and pins
+ worker w to the w-th CPU this process may run on. The count exchanges are
+ split evenly between the workers up front, and each worker runs its share
+ back to back with jintai_run() on its own context, so workers share no
+ mutable state: every worker has its own sampler, arena and wire buffers.
+
+ The contexts should be created with jintai_ctx_init(1), so a worker does
+ not start OpenMP threads of its own for PA on top of the pool.
+*/
+
+typedef struct {
+  size_t exchanges;            // Exchanges run
+  size_t failures;             // Exchanges whose keys did not match
+  int threads;                 // Worker threads used
+  double seconds;              // Wall clock time of the whole batch
+  double exchanges_per_second;
+} jintai_batch_stats_t;
+
+/*------------------------------Function Prototypes---------------------------*/
+
+// Run count exchanges on threads workers, worker w using ctx_array[w] (threads contexts are needed)
+extern jintai_batch_stats_t jintai_run_batch(jintai_ctx_t **ctx_array, size_t count, int threads);
+
+// Number of CPUs this process may run on
+extern int jintai_batch_cpus();
+
+/*---------------------------End of Function Prototypes-----------------------*/
+
+#endif
@@ -15,65 +15,100 @@
  * Core parameters and function prototypes for the PQC implementation
  */
 
-#include <stdbool.h>
-#include "dgs.h"
-
 #ifndef HEADER_JINTAILWE_H
+#define HEADER_JINTAILWE_H
 
-#define LATTICE_DIMENSION 512 // Matrix Dimension
-#define MODULO_Q 2147483647 // q - The modulo factor
+#include <stdbool.h>
+#include "dgs.h"
+#include "lwe_params.h"
+#include "lwe_expand.h"
+#include "lwe_arena.h"
 
 struct vector_params{
-  int *secret_vector;
-  int *public_vector;
+  lwe_vector_t secret_vector;
+  lwe_vector_t public_vector;
 };
 
 struct matrix_params{
-  int **secret_matrix;
-  int **public_matrix;
+  lwe_matrix_t secret_matrix; //LATTICE_DIMENSION x LATTICE_DIMENSION
+  lwe_matrix_t public_matrix; //LATTICE_DIMENSION x LATTICE_DIMENSION
 };
 
-/*-----------------------------Global Variables-------------------------------*/
-int M[LATTICE_DIMENSION][LATTICE_DIMENSION]; //Public parameter M
-int M_TRANSPOSE[LATTICE_DIMENSION][LATTICE_DIMENSION]; //M transpose
-struct matrix_params Alice_params;
-struct vector_params Alice1_params;
-struct vector_params Bob_params;
-
-//Alice Params
-int **EA; //Alices Error Matrix
-int *edashA; //Alices other error vector
-int *KA;
-int *SKA;
-
-//Bob Params
-int *eB; //Bobs Error vector
-int *edashB; //Bobs Error Scalar
-int *KB;
-int *SKB;
-
-//Signal generated
-int *sig; //either 0 or 1 at any index
-
-//-----DGS-----//
-dgs_disc_gauss_dp_t *D;
-
-//------TEST RESULTS-----//
-int vector_mem = (LATTICE_DIMENSION*sizeof(int));
-int matrix_mem = (LATTICE_DIMENSION*LATTICE_DIMENSION*sizeof(int));
-
-int Alice0_mem_vector = 1; //edashA
-int Alice0_mem_matrix = 3; //SA, EA, PA
-int Bob_mem_vector = 6; //sB, eB, edashB, pB, KB, sigma
-int Alice1_mem_vector = 2;
+/*
+ Everything one key exchange touches lives in a jintai_ctx_t: the seed of M,
+ Alice's and Bob's parameters, the wire buffers, the sampler and the timings.
+ Contexts share nothing mutable, so any number of them can run side by side in
+ one process, each on its own thread.
+
+   jintai_ctx_t *ctx = jintai_ctx_init(0);
+   if(jintai_run(ctx)){ ... ctx->SKA.data ... }
+   jintai_ctx_free(ctx);
+
+ jintai_run() may be called again on the same context: it resets the arena and
+ runs a fresh exchange in the same memory.
+*/
+
+typedef struct {
+  uint8_t M_seed[LWE_SEED_BYTES]; //Public parameter M, expanded from this seed inside the products
+  lwe_arena_t arena; //Backing memory of every buffer below, reset for each exchange
+
+  struct matrix_params Alice_params;
+  struct vector_params Alice1_params;
+  struct vector_params Bob_params;
+
+  //Alice Params
+  lwe_matrix_t EA; //Alices Error Matrix
+  lwe_vector_t edashA; //Alices other error vector
+  lwe_vector_t KA;
+  lwe_vector_t SKA;
+
+  //Bob Params
+  lwe_vector_t eB; //Bobs Error vector
+  lwe_vector_t edashB; //Bobs Error Scalar
+  lwe_vector_t KB;
+  lwe_vector_t SKB;
+
+  //Signal generated
+  lwe_vector_t sig; //either 0 or 1 at any index
+
+  //Wire buffers, packed with lwe_pack()
+  uint8_t *A_to_B_wire; //PA
+  uint8_t *B_to_A_wire; //pB
+
+  void *scratch; //Working memory of lwe_gemm_seeded() and lwe_matvec_transposed_seeded()
+
+  //-----DGS-----//
+  dgs_disc_gauss_dp_t *D;
+
+  int gemm_threads; //Threads computing PA, the OpenMP default if jintai_ctx_init() was given <= 0
+  unsigned int rand_state; //rand_r() state for the signal bits
+
+  //-----TIMINGS (seconds of wall clock, from the last jintai_run())-----//
+  double time_taken_M;
+  double time_taken_Alice0;
+  double time_taken_Bob;
+  double time_taken_Alice1;
+  double time_taken_gemm;
+} jintai_ctx_t;
+
 /*------------------------------Function Prototypes---------------------------*/
-extern void run_key_exchange(int argc, char **argv); //Running the key exchange protocol based on public params
+extern jintai_ctx_t *jintai_ctx_init(int gemm_threads); // Allocate a context, its sampler and its arena
+
+extern bool jintai_run(jintai_ctx_t *ctx); // Run one key exchange, true if Alice and Bob share the same key
+
+extern void jintai_ctx_free(jintai_ctx_t *ctx); // Release a context
+
+extern void run_key_exchange(jintai_ctx_t *ctx, int argc, char **argv); //Running the key exchange protocol based on public params
+
+extern size_t session_bytes(int gemm_threads); // Size of the arena holding all the buffers of one exchange
+
+extern void allocate_session(jintai_ctx_t *ctx); // Carve the buffers of one exchange out of ctx->arena
 
-extern void generate_gaussian_matrix(); // Generate a matrix sampled from the Discrete Gaussian distribution
+extern void generate_gaussian_matrix(jintai_ctx_t *ctx, lwe_matrix_t *gauss_matrix); // Generate a matrix sampled from the Discrete Gaussian distribution
 
-extern void generate_gaussian_vector(int gauss_vec[LATTICE_DIMENSION]); // Generate a vector sampled from the Discrete Gaussian distribution
+extern void generate_gaussian_vector(jintai_ctx_t *ctx, int gauss_vec[LATTICE_DIMENSION]); // Generate a vector sampled from the Discrete Gaussian distribution
 
-extern int generate_gaussian_scalar(); // Generate a discrete gaussian scalar value
+extern int generate_gaussian_scalar(jintai_ctx_t *ctx); // Generate a discrete gaussian scalar value
 
 extern int robust_extractor(int x, int sigma); // Find the same shared key
 
@@ -83,18 +118,20 @@ extern int signal_function(int y, int b); // A hint algorithm
 
 //----- Printing functions-----
 extern void pretty_print_vector(int vec[LATTICE_DIMENSION]); //Prints a vector
-extern void pretty_print_matrix(int **matrix); //Prints a matrix
+extern void pretty_print_matrix(const lwe_matrix_t *matrix); //Prints a matrix
 
 //----- Test Result Functions --
-extern void memory_consumed();
+extern void memory_consumed(const jintai_ctx_t *ctx);
 extern void communication_complexity();
+extern void batch_throughput(int argc, char **argv); // --batch [exchanges] [threads]
+extern void time_samplers(); // --time-samplers
 
 //------------------ Public Parameters for the key Exchange -------------------
-extern void generate_M();
+extern void generate_M(jintai_ctx_t *ctx);
 
 
 //------------------ Generate gaussian numbers in C ----------------------------
-extern inline long discrete_normal_distribution();
+extern long discrete_normal_distribution(jintai_ctx_t *ctx);
 
 /*---------------------------End of Function Prototypes-----------------------*/
 
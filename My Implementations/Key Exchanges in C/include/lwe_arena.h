@@ -0,0 +1,82 @@
+/********************************************************************************************
+ * A simple provably secure key exchange based on the learning with errors problem
+ *
+ *
+ * Based on the paper:
+ *     Jintai Ding, Xiang Xie and Xiaodong Ling
+ *
+ * Copyright (c) Jintai Ding, Xiang Xie and Xiaodong Ling for the theoretical key exchange
+ *               Afraz Arif Khan for implementing the key exchange in C and TLS
+ *
+ * Released under the MIT License; see LICENSE.txt for details.
+ ********************************************************************************************/
+
+/** \file lwe_arena.h
+ * Aligned matrix and vector types carved out of a per-session arena
+ */
+
+#ifndef HEADER_LWE_ARENA_H
+#define HEADER_LWE_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ Everything a key exchange needs is allocated once, as one block, and handed
+ out by bumping a pointer. Every allocation starts on a 64 byte (cache line)
+ boundary and matrix rows are padded to a multiple of 64 bytes, so row r of a
+ matrix starts at data + r*stride and never shares a line with its
+ neighbours. lwe_arena_reset() gives the whole block back at once, so the next
+ exchange reuses the same, already mapped, memory.
+*/
+
+#define LWE_ARENA_ALIGN 64 // Alignment of every allocation in bytes
+
+typedef struct {
+  uint8_t *base; // One LWE_ARENA_ALIGN aligned block
+  size_t size;   // Bytes in the block
+  size_t used;   // Bytes handed out since the last reset
+} lwe_arena_t;
+
+typedef struct {
+  int *data;     // Row major, row r starts at data + r*stride
+  size_t rows;
+  size_t cols;
+  size_t stride; // Ints per row, cols rounded up to a whole number of cache lines
+} lwe_matrix_t;
+
+typedef struct {
+  int *data;
+  size_t len;
+} lwe_vector_t;
+
+#define LWE_MATRIX_ROW(m, r) ((m)->data + (r)*(m)->stride) // Pointer to row r of an lwe_matrix_t*
+
+/*------------------------------Function Prototypes---------------------------*/
+
+// Bytes an allocation of the given size takes out of an arena
+extern size_t lwe_arena_bytes(size_t bytes);
+
+// Bytes taken by a rows x cols matrix and by a vector of len ints
+extern size_t lwe_matrix_bytes(size_t rows, size_t cols);
+extern size_t lwe_vector_bytes(size_t len);
+
+// Allocate the backing block of an arena holding size bytes
+extern void lwe_arena_init(lwe_arena_t *arena, size_t size);
+
+// Hand out an aligned block of bytes, aborts if the arena is exhausted
+extern void *lwe_arena_alloc(lwe_arena_t *arena, size_t bytes);
+
+// Give back everything handed out so far
+extern void lwe_arena_reset(lwe_arena_t *arena);
+
+// Release the backing block
+extern void lwe_arena_free(lwe_arena_t *arena);
+
+// Carve a rows x cols matrix and a vector of len ints out of an arena
+extern void lwe_matrix_alloc(lwe_matrix_t *m, lwe_arena_t *arena, size_t rows, size_t cols);
+extern void lwe_vector_alloc(lwe_vector_t *v, lwe_arena_t *arena, size_t len);
+
+/*---------------------------End of Function Prototypes-----------------------*/
+
+#endif
@@ -0,0 +1,45 @@
+/********************************************************************************************
+ * A simple provably secure key exchange based on the learning with errors problem
+ *
+ *
+ * Based on the paper:
+ *     Jintai Ding, Xiang Xie and Xiaodong Ling
+ *
+ * Copyright (c) Jintai Ding, Xiang Xie and Xiaodong Ling for the theoretical key exchange
+ *               Afraz Arif Khan for implementing the key exchange in C and TLS
+ *
+ * Released under the MIT License; see LICENSE.txt for details.
+ ********************************************************************************************/
+
+/** \file lwe_expand.h
+ * Deterministic expansion of the public matrix M from a short seed
+ */
+
+#ifndef HEADER_LWE_EXPAND_H
+#define HEADER_LWE_EXPAND_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "lwe_params.h"
+
+/*
+ Row i of M is read from SHAKE128(seed || i), with i as two little endian bytes.
+ Every 4 bytes of output give a candidate, masked to the bit length of q - 1 and
+ rejected unless it is below q, so the rows are uniform mod q. Any peer holding
+ the seed rebuilds exactly the same rows, in any order and on any thread, so M
+ never has to be stored or sent. The products in lwe_matvec.h and lwe_gemm.h
+ take the seed and expand one panel of rows at a time.
+*/
+
+#define LWE_SEED_BYTES 32 // Size of the seed defining M
+
+/*------------------------------Function Prototypes---------------------------*/
+
+// Write rows first, ..., first + nrows - 1 of M (cols wide) to rows, with a row stride of stride ints
+extern void lwe_expand_rows(int *rows, size_t stride, const uint8_t seed[LWE_SEED_BYTES],
+                            size_t first, size_t nrows, size_t cols);
+
+/*---------------------------End of Function Prototypes-----------------------*/
+
+#endif
@@ -0,0 +1,73 @@
+/********************************************************************************************
+ * A simple provably secure key exchange based on the learning with errors problem
+ *
+ *
+ * Based on the paper:
+ *     Jintai Ding, Xiang Xie and Xiaodong Ling
+ *
+ * Copyright (c) Jintai Ding, Xiang Xie and Xiaodong Ling for the theoretical key exchange
+ *               Afraz Arif Khan for implementing the key exchange in C and TLS
+ *
+ * Released under the MIT License; see LICENSE.txt for details.
+ ********************************************************************************************/
+
+/** \file lwe_gemm.h
+ * Blocked, multithreaded matrix-matrix product modulo q
+ */
+
+#ifndef HEADER_LWE_GEMM_H
+#define HEADER_LWE_GEMM_H
+
+#include <stddef.h>
+
+#include "lwe_params.h"
+#include "lwe_matvec.h"
+#include "lwe_expand.h"
+
+/*
+ C = (A·B + 2·E) mod q is computed one row panel of LWE_GEMM_MC rows at a time,
+ the panels being shared out between OpenMP threads. Inside a panel every row
+ of C is the product B^T·A[i], so the mat-vec panel kernel does the work: a
+ slab of LWE_GEMM_KC rows of B (64 x 512 x 4 bytes = 128KB) is reused from L2
+ by all rows of the panel while each row keeps its strip of int64_t
+ accumulators in L1. Slabs that are not already contiguous are packed first.
+
+ A must hold values reduced mod q. B may be bounded by b_bound, which sets how
+ often the accumulators need a reduction (see lwe_modq_lazy_terms()).
+
+ lwe_gemm_seeded() takes A as the seed it was expanded from (see lwe_expand.h)
+ instead: each thread expands the rows of its own panel into a private buffer
+ just before using them, so A is never stored and expansion runs in parallel.
+
+ Nothing is allocated inside the product. The caller passes a scratch block
+ of lwe_gemm_scratch_bytes() bytes, 64 byte aligned (an lwe_arena_alloc()
+ does), and each thread works in its own slice of it.
+*/
+
+#define LWE_GEMM_MC 64                   // Rows of C per thread work item
+#define LWE_GEMM_KC LWE_MATVEC_TILE_ROWS // Rows of B per slab
+#define LWE_GEMM_NC LWE_MATVEC_TILE_COLS // Columns of B per slab
+
+/*------------------------------Function Prototypes---------------------------*/
+
+// Threads a product asked for threads will run on: threads itself, or the OpenMP default if threads <= 0
+extern int lwe_gemm_threads(int threads);
+
+// Bytes of scratch a product with k columns of A needs on lwe_gemm_threads(threads) threads
+extern size_t lwe_gemm_scratch_bytes(size_t k, int threads);
+
+// C = (A·B + 2·E) mod q for A m x k, B k x n, C and E m x n (E may be NULL), each with its own row stride.
+// b_bound bounds |B[i][j]| (0 if B is only known to be reduced mod q), threads <= 0 picks the OpenMP default.
+// scratch holds at least lwe_gemm_scratch_bytes(k, threads) bytes.
+extern void lwe_gemm(int *C, size_t ldc, const int *A, size_t lda, const int *B, size_t ldb,
+                     const int *E, size_t lde, size_t m, size_t k, size_t n, unsigned int b_bound, int threads,
+                     void *scratch);
+
+// As lwe_gemm() with A the m x k matrix expanded from seed
+extern void lwe_gemm_seeded(int *C, size_t ldc, const uint8_t seed[LWE_SEED_BYTES], const int *B, size_t ldb,
+                            const int *E, size_t lde, size_t m, size_t k, size_t n, unsigned int b_bound, int threads,
+                            void *scratch);
+
+/*---------------------------End of Function Prototypes-----------------------*/
+
+#endif
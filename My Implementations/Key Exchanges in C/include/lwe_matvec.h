@@ -0,0 +1,74 @@
+/********************************************************************************************
+ * A simple provably secure key exchange based on the learning with errors problem
+ *
+ *
+ * Based on the paper:
+ *     Jintai Ding, Xiang Xie and Xiaodong Ling
+ *
+ * Copyright (c) Jintai Ding, Xiang Xie and Xiaodong Ling for the theoretical key exchange
+ *               Afraz Arif Khan for implementing the key exchange in C and TLS
+ *
+ * Released under the MIT License; see LICENSE.txt for details.
+ ********************************************************************************************/
+
+/** \file lwe_matvec.h
+ * Cache-blocked matrix-vector products modulo q over contiguous row-major storage
+ */
+
+#ifndef HEADER_LWE_MATVEC_H
+#define HEADER_LWE_MATVEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "lwe_params.h"
+#include "lwe_expand.h"
+
+/*
+ Every product in the key exchange has the form A^T·x where A is stored row
+ major, so we never transpose: row r of A is scaled by x[r] and added into a
+ strip of 64-bit accumulators. The strip is LWE_MATVEC_TILE_COLS wide so the
+ accumulators stay in L1, and a panel of at most LWE_MATVEC_TILE_ROWS rows of
+ that strip (64 x 512 x 4 bytes = 128KB) stays in L2.
+
+ The accumulators are reduced lazily (see lwe_modq.h): the number of rows
+ between two reductions follows from a_bound·max|x|. In the key exchange one
+ operand is always a secret sampled from the discrete Gaussian, so a whole
+ n = 512 product is accumulated with a single reduction per coefficient.
+
+ The inner panel kernel is picked once at startup from CPUID: AVX-512F, AVX2 or
+ plain C. All three produce identical results, so one binary runs everywhere.
+*/
+
+#define LWE_MATVEC_TILE_COLS 512 // Accumulator strip width (4KB of int64_t)
+#define LWE_MATVEC_TILE_ROWS 64  // Rows per panel handed to the kernel
+
+/*------------------------------Function Prototypes---------------------------*/
+
+// Select the fastest panel kernel supported by this CPU, once and safe from any thread (called lazily if omitted)
+extern void lwe_matvec_init();
+
+// Name of the selected panel kernel: "avx512", "avx2" or "scalar"
+extern const char *lwe_matvec_kernel_name();
+
+// acc[c] += sum of A[r][c]*x[r] over rows x cols, without any reduction (see lwe_modq_lazy_terms())
+extern void lwe_matvec_accumulate(int64_t *acc, const int *A, size_t stride, size_t rows, size_t cols,
+                                  const int *x);
+
+// y = (A^T·x + 2·e) mod q, A is rows x cols with a row stride of stride ints, e may be NULL.
+// a_bound is a bound on |A[r][c]|, or 0 if A is only known to hold values reduced mod q.
+extern void lwe_matvec_transposed(int *y, const int *A, size_t stride, size_t rows, size_t cols,
+                                  unsigned int a_bound, const int *x, const int *e);
+
+// Bytes of scratch lwe_matvec_transposed_seeded() needs for cols columns
+extern size_t lwe_matvec_seeded_scratch_bytes(size_t cols);
+
+// As lwe_matvec_transposed() with A the rows x cols matrix expanded from seed (see lwe_expand.h).
+// One panel of rows is expanded at a time into scratch, 64 byte aligned and lwe_matvec_seeded_scratch_bytes(cols)
+// long, so A is never held in memory as a whole.
+extern void lwe_matvec_transposed_seeded(int *y, const uint8_t seed[LWE_SEED_BYTES], size_t rows, size_t cols,
+                                         const int *x, const int *e, void *scratch);
+
+/*---------------------------End of Function Prototypes-----------------------*/
+
+#endif
@@ -0,0 +1,82 @@
+/********************************************************************************************
+ * A simple provably secure key exchange based on the learning with errors problem
+ *
+ *
+ * Based on the paper:
+ *     Jintai Ding, Xiang Xie and Xiaodong Ling
+ *
+ * Copyright (c) Jintai Ding, Xiang Xie and Xiaodong Ling for the theoretical key exchange
+ *               Afraz Arif Khan for implementing the key exchange in C and TLS
+ *
+ * Released under the MIT License; see LICENSE.txt for details.
+ ********************************************************************************************/
+
+/** \file lwe_modq.h
+ * Division free arithmetic modulo q
+ */
+
+#ifndef HEADER_LWE_MODQ_H
+#define HEADER_LWE_MODQ_H
+
+#include <stdint.h>
+
+#include "lwe_params.h"
+
+/*
+ Products are accumulated lazily in int64_t and only reduced when the next batch
+ of products could overflow, see lwe_modq_lazy_terms().
+
+ The default q = 2^31 - 1 is a Mersenne prime, so x mod q is two shift-add folds
+ (2^31 = 1 mod q) and one conditional subtraction. Any other q falls back to
+ Barrett reduction with a precomputed floor((2^64-1)/q). Neither needs a
+ division at run time. q must be below 2^31 in both cases.
+*/
+
+#if ((MODULO_Q) & ((MODULO_Q) + 1)) == 0
+#define LWE_MODQ_MERSENNE 1
+#define LWE_MODQ_BITS (__builtin_ctzll((uint64_t)(MODULO_Q) + 1)) // q = 2^LWE_MODQ_BITS - 1
+#else
+#define LWE_MODQ_BARRETT ((uint64_t)(UINT64_MAX / (MODULO_Q))) // floor((2^64-1)/q)
+#endif
+
+#define LWE_MODQ_2_64 ((uint64_t)(((unsigned __int128)1 << 64) % (MODULO_Q))) // 2^64 mod q
+
+#define LWE_MODQ_LAZY_HEADROOM ((int64_t)1 << 33) // Room for the starting value of an accumulator
+
+// Reduce an unsigned 64-bit value to [0, q)
+static inline uint64_t lwe_modq_reduce_u64(uint64_t x){
+#ifdef LWE_MODQ_MERSENNE
+  x = (x & (MODULO_Q)) + (x >> LWE_MODQ_BITS);
+  x = (x & (MODULO_Q)) + (x >> LWE_MODQ_BITS);
+  return (x >= (MODULO_Q)) ? x - (MODULO_Q) : x;
+#else
+  uint64_t qhat = (uint64_t)(((unsigned __int128)x * LWE_MODQ_BARRETT) >> 64);
+  x -= qhat * (MODULO_Q);
+  x = (x >= (MODULO_Q)) ? x - (MODULO_Q) : x;
+  return (x >= (MODULO_Q)) ? x - (MODULO_Q) : x;
+#endif
+}
+
+// Reduce a signed 64-bit value to [0, q): a negative x reads as x + 2^64 when cast
+static inline int lwe_modq_reduce(int64_t x){
+  uint64_t r = lwe_modq_reduce_u64((uint64_t)x);
+  if(x < 0){
+    r = (r >= LWE_MODQ_2_64) ? r - LWE_MODQ_2_64 : r + (MODULO_Q) - LWE_MODQ_2_64;
+  }
+  return (int)r;
+}
+
+// (a*b) mod q for any a, b in (-2^31, 2^31)
+static inline int lwe_modq_mul(int a, int b){
+  return lwe_modq_reduce((int64_t)a*b);
+}
+
+// How many products of magnitude at most max_product fit into a reduced accumulator
+static inline uint64_t lwe_modq_lazy_terms(uint64_t max_product){
+  if(max_product == 0){
+    return UINT64_MAX;
+  }
+  return (uint64_t)(INT64_MAX - LWE_MODQ_LAZY_HEADROOM) / max_product;
+}
+
+#endif
@@ -0,0 +1,61 @@
+/********************************************************************************************
+ * A simple provably secure key exchange based on the learning with errors problem
+ *
+ *
+ * Based on the paper:
+ *     Jintai Ding, Xiang Xie and Xiaodong Ling
+ *
+ * Copyright (c) Jintai Ding, Xiang Xie and Xiaodong Ling for the theoretical key exchange
+ *               Afraz Arif Khan for implementing the key exchange in C and TLS
+ *
+ * Released under the MIT License; see LICENSE.txt for details.
+ ********************************************************************************************/
+
+/** \file lwe_pack.h
+ * Bit-packed wire encoding of vectors and matrices modulo q
+ */
+
+#ifndef HEADER_LWE_PACK_H
+#define HEADER_LWE_PACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "lwe_params.h"
+
+/*
+ A coefficient in [0, q) needs LWE_PACK_BITS = ceil(log2 q) bits, 31 for the
+ default q, instead of the 32 of an int. Coefficients are written back to back
+ as a little endian bit stream, so n values take ceil(n·LWE_PACK_BITS/8) bytes.
+
+ With d > 0 the d low order bits are dropped as well: a coefficient is sent as
+ round(v/2^d) and read back as that value times 2^d, which is within 2^(d-1)
+ of v mod q. This trades bandwidth for extra noise in the shared key, so d
+ must stay small next to the reconciliation margin q/4.
+
+ Both directions work on 64-bit words and write straight into and out of the
+ caller's buffers. Matrices with padded rows are sent row by row, every row
+ starting on a fresh byte.
+*/
+
+#define LWE_PACK_BITS (64 - __builtin_clzll((uint64_t)(MODULO_Q) - 1)) // ceil(log2 q)
+
+/*------------------------------Function Prototypes---------------------------*/
+
+// Bytes taken by count coefficients with d low order bits dropped
+extern size_t lwe_pack_bytes(size_t count, unsigned int d);
+
+// Pack count coefficients in [0, q) into lwe_pack_bytes(count, d) bytes of out
+extern void lwe_pack(uint8_t *out, const int *in, size_t count, unsigned int d);
+
+// Unpack count coefficients written by lwe_pack(), out holds values in [0, q)
+extern void lwe_unpack(int *out, const uint8_t *in, size_t count, unsigned int d);
+
+// The same for a rows x cols matrix with a row stride of stride ints
+extern size_t lwe_pack_rows_bytes(size_t rows, size_t cols, unsigned int d);
+extern void lwe_pack_rows(uint8_t *out, const int *in, size_t stride, size_t rows, size_t cols, unsigned int d);
+extern void lwe_unpack_rows(int *out, size_t stride, const uint8_t *in, size_t rows, size_t cols, unsigned int d);
+
+/*---------------------------End of Function Prototypes-----------------------*/
+
+#endif
@@ -0,0 +1,25 @@
+/********************************************************************************************
+ * A simple provably secure key exchange based on the learning with errors problem
+ *
+ *
+ * Based on the paper:
+ *     Jintai Ding, Xiang Xie and Xiaodong Ling
+ *
+ * Copyright (c) Jintai Ding, Xiang Xie and Xiaodong Ling for the theoretical key exchange
+ *               Afraz Arif Khan for implementing the key exchange in C and TLS
+ *
+ * Released under the MIT License; see LICENSE.txt for details.
+ ********************************************************************************************/
+
+/** \file lwe_params.h
+ * Lattice parameters shared by the key exchange and the linear algebra routines
+ */
+
+#ifndef HEADER_LWE_PARAMS_H
+#define HEADER_LWE_PARAMS_H
+
+#define LATTICE_DIMENSION 512 // Matrix Dimension
+#define MODULO_Q 2147483647 // q - The modulo factor
+#define LWE_PACK_DROP_BITS 0 // Low order bits of PA and pB dropped on the wire (see lwe_pack.h)
+
+#endif
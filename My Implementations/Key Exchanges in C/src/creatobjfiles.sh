@@ -1,6 +1,15 @@
 mkdir obj
 #CFLAGS= -Wall -g -std=c11
 gcc -c jintailwe.c -Wall -g -std=c11 -I../include -o jintailwe.o
+gcc -c lwe_matvec.c -Wall -g -std=c11 -I../include -o lwe_matvec.o
+gcc -c lwe_gemm.c -Wall -g -std=c11 -fopenmp -I../include -o lwe_gemm.o
+gcc -c lwe_expand.c -Wall -g -std=c11 -I../include -o lwe_expand.o
+gcc -c fips202.c -Wall -g -std=c11 -I../include -o fips202.o
+gcc -c lwe_pack.c -Wall -g -std=c11 -I../include -o lwe_pack.o
+gcc -c lwe_arena.c -Wall -g -std=c11 -I../include -o lwe_arena.o
+gcc -c jintai_batch.c -Wall -g -std=c11 -I../include -o jintai_batch.o
+gcc -c dgs_rng.c -Wall -g -std=c11 -I../include -o dgs_rng.o
+gcc -c dgs_cache.c -Wall -g -std=c11 -I../include -o dgs_cache.o
 gcc -c dgs_bern.c -Wall -g -std=c11 -I../include -o dgs_bern.o
 gcc -c dgs_gauss_dp.c -Wall -g -std=c11 -I../include -o dgs_gauss_dp.o
 gcc -c dgs_gauss_mp.c -Wall -g -std=c11 -I../include -o dgs_gauss_mp.o
@@ -93,6 +93,24 @@ void dgs_bern_mp_clear(dgs_bern_mp_t *self) {
   free(self);
 }
 
+dgs_u128_t dgs_u128_set_mpfr(const mpfr_t p) {
+  mpfr_t t;
+  mpz_t v;
+  uint64_t w[2] = {0, 0};
+  mpfr_init2(t, mpfr_get_prec(p));
+  mpz_init(v);
+  mpfr_mul_2ui(t, p, 128, MPFR_RNDN);
+  mpfr_get_z(v, t, MPFR_RNDD);
+  dgs_u128_t r = ~(dgs_u128_t)0;
+  if (mpz_sizeinbase(v, 2) <= 128) {
+    mpz_export(w, NULL, -1, sizeof(uint64_t), 0, 0, v);
+    r = (dgs_u128_t)w[1] << 64 | w[0];
+  }
+  mpz_clear(v);
+  mpfr_clear(t);
+  return r;
+}
+
 /*
  * Bernoulli with p = exp(-x/f) for integers x, multi-precision version
  */
@@ -101,48 +119,51 @@ dgs_bern_exp_mp_t* dgs_bern_exp_mp_init(mpfr_t f, size_t l) {
   dgs_bern_exp_mp_t *self = (dgs_bern_exp_mp_t *)malloc(sizeof(dgs_bern_exp_mp_t));
   if (!self) dgs_die("out of memory");
 
-  /* l == 0, means we use the precision of f to decide l */
-  if (l == 0)
-    l = SIZE_MAX;
+  const mpfr_prec_t prec = mpfr_get_prec(f);
+
+  /* exp(-2^i/f) is zero once 2^i/f > 2^64 > |emin|·log(2), i.e. for i >= e+64
+     where f < 2^e. l == 0, means we stop at the first zero */
+  const mpfr_exp_t e = mpfr_get_exp(f);
+  const size_t lmax = ((e > 0) ? (size_t)e : 0) + 64;
+  if (l == 0 || l > lmax)
+    l = lmax;
 
-  self->l = DGS_BERN_EXP_ALLOC_BLOCK_SIZE;
-  self->p = (mpfr_t*)malloc(sizeof(mpfr_t)*self->l);
+  self->p = (mpfr_t*)malloc(sizeof(mpfr_t)*l);
   if (!self->p) dgs_die("out of memory");
-  self->B = (dgs_bern_mp_t**)malloc(sizeof(dgs_bern_mp_t)*self->l);
+  self->B = (dgs_bern_mp_t**)malloc(sizeof(dgs_bern_mp_t*)*l);
   if (!self->B) dgs_die("out of memory");
 
-  mpfr_t tmp, tmp2;
-  mpfr_init2(tmp2, mpfr_get_prec(f));
-  mpfr_init2(tmp, mpfr_get_prec(f));
+  mpfr_t tmp;
+  mpfr_init2(tmp, prec);
   mpfr_set(tmp, f, MPFR_RNDN); // f
   mpfr_pow_si(tmp, tmp, -1, MPFR_RNDN); // 1/f
   mpfr_neg(tmp, tmp, MPFR_RNDN); // -1/f
 
-  for(size_t i=0; i<l; i++) {
-    mpfr_exp(tmp2, tmp, MPFR_RNDN);
-    if (mpfr_zero_p(tmp2)) {
-      self->l = i;
-      break;
-    }
-    if (i%DGS_BERN_EXP_ALLOC_BLOCK_SIZE == 0 && i!=0) {
-      self->l += DGS_BERN_EXP_ALLOC_BLOCK_SIZE;
-      self->l = (l>self->l) ? self->l : l;
-      self->p = realloc(self->p, sizeof(mpfr_t)*self->l);
-      if(!self->p) dgs_die("out of memory");
-      self->B = realloc(self->B, sizeof(dgs_bern_exp_mp_t)*self->l);
-      if(!self->B) dgs_die("out of memory");
-    }
+  /* p[i] = exp(-2^i/f), larger i are dearer */
+  const int parallel = (l*prec >= DGS_MP_PARALLEL_MIN_WORK) && mpfr_buildopt_tls_p();
+  #pragma omp parallel for schedule(dynamic) if(parallel)
+  for(long i=0; i<(long)l; i++) {
+    mpfr_init2(self->p[i], prec);
+    mpfr_mul_2ui(self->p[i], tmp, i, MPFR_RNDN);
+    mpfr_exp(self->p[i], self->p[i], MPFR_RNDN);
+  }
 
-    mpfr_init2(self->p[i], mpfr_get_prec(f));
-    mpfr_set(self->p[i], tmp2, MPFR_RNDN);
-    self->B[i] = dgs_bern_mp_init(self->p[i]);
+  self->l = 0;
+  while (self->l < l && !mpfr_zero_p(self->p[self->l])) {
+    self->B[self->l] = dgs_bern_mp_init(self->p[self->l]);
+    self->l++;
+  }
+  for(size_t i=self->l; i<l; i++)
+    mpfr_clear(self->p[i]);
 
-    mpfr_mul_ui(tmp, tmp, 2, MPFR_RNDN);
+  self->p_u128 = NULL;
+  if (mpfr_get_prec(f) <= DGS_MP_U128_MAX_PREC) {
+    self->p_u128 = (dgs_u128_t*)malloc(sizeof(dgs_u128_t)*(self->l ? self->l : 1));
+    if (!self->p_u128) dgs_die("out of memory");
+    for(size_t i=0; i<self->l; i++)
+      self->p_u128[i] = dgs_u128_set_mpfr(self->p[i]);
   }
-  if (l < self->l)
-    self->l = l;
   mpfr_clear(tmp);
-  mpfr_clear(tmp2);
   return self;
 }
 
@@ -150,6 +171,14 @@ long dgs_bern_exp_mp_call(dgs_bern_exp_mp_t *self, mpz_t x, gmp_randstate_t stat
   assert(mpz_sgn(x) >= 0);
   long int start = (mpz_sizeinbase(x, 2) < self->l) ? mpz_sizeinbase(x, 2) : self->l;
 
+  if (self->p_u128) {
+    for(long int i=start-1; i>=0; i--) {
+      if (mpz_tstbit(x, i) && !dgs_bern_u128_call(self->p_u128[i], state))
+        return 0;
+    }
+    return 1;
+  }
+
   for(long int i=start-1; i>=0; i--) {
     if (mpz_tstbit(x, i)) {
       if (dgs_bern_mp_call(self->B[i], state) == 0) {
@@ -172,6 +201,8 @@ void dgs_bern_exp_mp_clear(dgs_bern_exp_mp_t *self) {
     free(self->p);
   if(self->B)
     free(self->B);
+  if(self->p_u128)
+    free(self->p_u128);
   free(self);
 }
 
@@ -190,8 +221,8 @@ dgs_bern_dp_t* dgs_bern_dp_init(double p) {
   return self;
 }
 
-long dgs_bern_dp_call(dgs_bern_dp_t *self) {
-  double c = drand48();
+long dgs_bern_dp_call(dgs_bern_dp_t *self, dgs_rng_t *rng) {
+  double c = dgs_rng_uniform_double(rng);
   if (c<self->p)
     return 1;
   else
@@ -211,54 +242,65 @@ dgs_bern_exp_dp_t* dgs_bern_exp_dp_init(double f, size_t l) {
   if (!self) dgs_die("out of memory");
 
   /* l == 0, means we use the precision of f to decide l */
-  if (l == 0)
-    l = SIZE_MAX;
-
-  self->l = DGS_BERN_EXP_ALLOC_BLOCK_SIZE;
-  self->p = (double*)malloc(sizeof(double)*self->l);
-  if (!self->p) dgs_die("out of memory");
-  self->B = (dgs_bern_dp_t**)malloc(sizeof(dgs_bern_dp_t)*self->l);
-  if (!self->B) dgs_die("out of memory");
-
-  double tmp = -1.0/f;
-  double tmp2;
+  if (l == 0 || l > 63)
+    l = 63;
 
+  /* bits from which on exp(-x/f) is zero in double precision */
   for(size_t i=0; i<l; i++) {
-    tmp2 = exp(tmp);
-    if (tmp2 == 0.0) {
-      self->l = i;
+    if (exp(-ldexp(1.0, i)/f) == 0.0) {
+      l = i;
       break;
     }
-    if (i%DGS_BERN_EXP_ALLOC_BLOCK_SIZE == 0 && i!=0) {
-      self->l += DGS_BERN_EXP_ALLOC_BLOCK_SIZE;
-      self->l = (l>self->l) ? self->l : l;
-      self->p = realloc(self->p, sizeof(double)*self->l);
-      if(!self->p) dgs_die("out of memory");
-      self->B = realloc(self->B, sizeof(dgs_bern_exp_dp_t)*self->l);
-      if(!self->B) dgs_die("out of memory");
-    }
-
-    self->p[i] = tmp2;
-    self->B[i] = dgs_bern_dp_init(self->p[i]);
+  }
+  self->l = l;
+  double v_l = ldexp(exp(-ldexp(1.0, l)/f), 64);
+  self->p_l = (v_l >= ldexp(1.0, 64)) ? UINT64_MAX : (uint64_t)v_l;
+  self->digits = (l + DGS_BERN_EXP_DP_DIGIT_BITS - 1)/DGS_BERN_EXP_DP_DIGIT_BITS;
+  self->p = (uint64_t*)malloc(sizeof(uint64_t)*DGS_BERN_EXP_DP_DIGIT_SIZE*(self->digits ? self->digits : 1));
+  if (!self->p) dgs_die("out of memory");
 
-    tmp = 2*tmp;
+  for(size_t j=0; j<self->digits; j++) {
+    for(long d=0; d<DGS_BERN_EXP_DP_DIGIT_SIZE; d++) {
+      double v = ldexp(exp(-ldexp((double)d, j*DGS_BERN_EXP_DP_DIGIT_BITS)/f), 64);
+      self->p[j*DGS_BERN_EXP_DP_DIGIT_SIZE + d] = (v >= ldexp(1.0, 64)) ? UINT64_MAX : (uint64_t)v;
+    }
   }
-  if (l < self->l)
-    self->l = l;
   return self;
 }
 
-long dgs_bern_exp_dp_call(dgs_bern_exp_dp_t *self, long x) {
-  if (x == 0)
-    return 1;
+long dgs_bern_exp_dp_call(dgs_bern_exp_dp_t *self, long x, dgs_rng_t *rng) {
   assert(x >= 0);
-  long start = self->l;
-  for(long i=start-1; i>=0; i--) {
-    if (x & (1L<<i)) {
-      if (dgs_bern_dp_call(self->B[i]) == 0) {
+  if (__DGS_UNLIKELY(((unsigned long)x) >> self->l)) {
+    /* exp(-x/f) = exp(-2^l/f)^⌊x/2^l⌋ · exp(-(x mod 2^l)/f) */
+    for(unsigned long h = ((unsigned long)x) >> self->l; h > 0; h--) {
+      if (dgs_rng_uniform_u64(rng) >= self->p_l)
         return 0;
-      }
     }
+    x &= (1L << self->l) - 1;
+  }
+
+  uint64_t pool = 0;
+  int bits = 0;
+  /* high digits first, they have the smallest probabilities */
+  for(long j=self->digits-1; j>=0; j--) {
+    long d = (x >> (j*DGS_BERN_EXP_DP_DIGIT_BITS)) & (DGS_BERN_EXP_DP_DIGIT_SIZE-1);
+    if (d == 0)
+      continue;
+    uint64_t t = self->p[j*DGS_BERN_EXP_DP_DIGIT_SIZE + d];
+    if (bits == 0) {
+      pool = dgs_rng_uniform_u64(rng);
+      bits = 64;
+    }
+    /* compare the top 16 bits of the uniform first, the rest only on a tie */
+    uint64_t r = pool >> 48;
+    pool <<= 16;
+    bits -= 16;
+    if (r < (t >> 48))
+      continue;
+    if (r > (t >> 48))
+      return 0;
+    if (dgs_rng_uniform_u64(rng) >= (t << 16))
+      return 0;
   }
   return 1;
 }
@@ -267,12 +309,7 @@ void dgs_bern_exp_dp_clear(dgs_bern_exp_dp_t *self) {
   if(!self)
     return;
 
-  for(size_t i=0; i<self->l; i++) {
-    dgs_bern_dp_clear(self->B[i]);
-  }
   if(self->p)
     free(self->p);
-  if(self->B)
-    free(self->B);
   free(self);
 }
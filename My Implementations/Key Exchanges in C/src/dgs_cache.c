@@ -0,0 +1,130 @@
+/**
+   On-disk cache of precomputed sampler tables.
+ */
+
+/******************************************************************************
+*
+*                      DGS - Discrete Gaussian Samplers
+*
+* Copyright (c) 2014, Martin Albrecht  <martinralbrecht+dgs@googlemail.com>
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are
+* those of the authors and should not be interpreted as representing official
+* policies, either expressed or implied, of the FreeBSD Project.
+******************************************************************************/
+
+#define _POSIX_C_SOURCE 200112L // mmap(), getpid()
+
+#include "dgs_cache.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define DGS_CACHE_ENDIAN 0x01020304
+
+/* <DGS_CACHE_DIR>/dgs-<FNV-1a hash of key>.tbl, or 0 if caching is disabled */
+static int _dgs_cache_path(char *path, size_t len, const char *key) {
+  const char *dir = getenv("DGS_CACHE_DIR");
+  if (!dir || !*dir || strlen(key) >= DGS_CACHE_KEY_SIZE)
+    return 0;
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for(const char *s = key; *s; s++) {
+    h ^= (unsigned char)*s;
+    h *= 0x100000001b3ULL;
+  }
+  int r = snprintf(path, len, "%s/dgs-%016llx.tbl", dir, (unsigned long long)h);
+  return r > 0 && (size_t)r < len;
+}
+
+static void _dgs_cache_header(dgs_cache_header_t *hdr, const char *key, size_t size) {
+  memset(hdr, 0, sizeof(dgs_cache_header_t));
+  memcpy(hdr->magic, "DGSCACHE", 8);
+  hdr->version = DGS_CACHE_VERSION;
+  hdr->endian = DGS_CACHE_ENDIAN;
+  hdr->long_size = sizeof(long);
+  hdr->size = size;
+  strncpy(hdr->key, key, DGS_CACHE_KEY_SIZE - 1);
+}
+
+const void *dgs_cache_load(dgs_cache_t *self, const char *key, size_t size) {
+  char path[4096];
+  self->map = NULL;
+  self->map_size = 0;
+  if (size == 0 || !_dgs_cache_path(path, sizeof(path), key))
+    return NULL;
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return NULL;
+  struct stat st;
+  const size_t map_size = DGS_CACHE_HEADER_SIZE + size;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size != map_size) {
+    close(fd);
+    return NULL;
+  }
+  void *map = mmap(NULL, map_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    return NULL;
+
+  dgs_cache_header_t expected;
+  _dgs_cache_header(&expected, key, size);
+  if (memcmp(map, &expected, sizeof(dgs_cache_header_t)) != 0) {
+    munmap(map, map_size);
+    return NULL;
+  }
+  self->map = map;
+  self->map_size = map_size;
+  return (const char*)map + DGS_CACHE_HEADER_SIZE;
+}
+
+void dgs_cache_store(const char *key, const void *data, size_t size) {
+  char path[4096], tmp[4096 + 32];
+  if (size == 0 || !_dgs_cache_path(path, sizeof(path), key))
+    return;
+  snprintf(tmp, sizeof(tmp), "%s.%ld.tmp", path, (long)getpid());
+
+  FILE *fh = fopen(tmp, "wb");
+  if (!fh)
+    return;
+  dgs_cache_header_t hdr;
+  char pad[DGS_CACHE_HEADER_SIZE - sizeof(dgs_cache_header_t)] = {0};
+  _dgs_cache_header(&hdr, key, size);
+  int ok = fwrite(&hdr, sizeof(hdr), 1, fh) == 1 && fwrite(pad, sizeof(pad), 1, fh) == 1
+    && fwrite(data, size, 1, fh) == 1;
+  ok = (fclose(fh) == 0) && ok;
+  if (!ok || rename(tmp, path) != 0)
+    remove(tmp);
+}
+
+void dgs_cache_clear(dgs_cache_t *self) {
+  if (self->map)
+    munmap(self->map, self->map_size);
+  self->map = NULL;
+  self->map_size = 0;
+}
@@ -32,8 +32,18 @@
 
 #include "dgs.h"
 #include <assert.h>
+#include <float.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define DGS_GAUSS_DP_X86 1
+#include <immintrin.h>
+#endif
+
+static void _dgs_disc_gauss_dp_init_cdt_scan(void);
 
 static inline void _dgs_disc_gauss_dp_init_bexp(dgs_disc_gauss_dp_t *self, double sigma, long upper_bound) {
   self->f = (2*sigma*sigma);
@@ -41,6 +51,29 @@ static inline void _dgs_disc_gauss_dp_init_bexp(dgs_disc_gauss_dp_t *self, doubl
   self->Bexp = dgs_bern_exp_dp_init(self->f, l);
 }
 
+/* key of the table name of this sampler in the on-disk cache */
+static inline void _dgs_disc_gauss_dp_cache_key(char *key, const dgs_disc_gauss_dp_t *self, const char *name) {
+  snprintf(key, DGS_CACHE_KEY_SIZE, "dp %s alg=%d sigma=%a c_r=%a tau=%zu prec=%d",
+           name, (int)self->algorithm, self->sigma, self->c_r, self->tau, DBL_MANT_DIG);
+}
+
+/* the cached table name of this sampler, NULL on a miss */
+static inline const void *_dgs_disc_gauss_dp_cache_load(dgs_disc_gauss_dp_t *self, const char *name, size_t size) {
+  if (self->nocache)
+    return NULL;
+  char key[DGS_CACHE_KEY_SIZE];
+  _dgs_disc_gauss_dp_cache_key(key, self, name);
+  return dgs_cache_load(&self->cache, key, size);
+}
+
+static inline void _dgs_disc_gauss_dp_cache_store(dgs_disc_gauss_dp_t *self, const char *name, const void *data, size_t size) {
+  if (self->nocache)
+    return;
+  char key[DGS_CACHE_KEY_SIZE];
+  _dgs_disc_gauss_dp_cache_key(key, self, name);
+  dgs_cache_store(key, data, size);
+}
+
 static inline void _dgs_disc_gauss_dp_init_rho(dgs_disc_gauss_dp_t *self) {
   self->rho = (double*)malloc(sizeof(double)*self->two_upper_bound_minus_one);
   if (!self->rho){
@@ -53,31 +86,53 @@ static inline void _dgs_disc_gauss_dp_init_rho(dgs_disc_gauss_dp_t *self) {
   }
 }
 
-static inline long _dgs_disc_gauss_dp_min_in_rho(dgs_disc_gauss_dp_t *self) {
-  long mi = 0;
-  double m = self->rho[mi];
-  for (long x = 1; x < self->two_upper_bound_minus_one;++x) {
-    if (self->rho[x] < m) {
-      mi = x;
-      m = self->rho[mi];
-    }
+/* cdt[i] = 2^63·(ρ(0)+...+ρ(i))/Σρ for the m values of rho[] */
+static inline void _dgs_disc_gauss_dp_init_cdt(dgs_disc_gauss_dp_t *self, const double *rho, long m) {
+  self->cdt_size = m - 1;
+  self->cdt = (int64_t*)malloc(sizeof(int64_t)*(m > 1 ? m - 1 : 1));
+  if (!self->cdt){
+    dgs_disc_gauss_dp_clear(self);
+    dgs_die("out of memory");
+  }
+  long double sum = 0, cum = 0;
+  for(long x=0; x<m; x++)
+    sum += rho[x];
+  for(long x=0; x<m-1; x++) {
+    cum += rho[x];
+    long double v = ldexpl(cum/sum, 63);
+    self->cdt[x] = (v >= ldexpl(1.0, 63)) ? INT64_MAX : (int64_t)llroundl(v);
   }
-  return mi;
 }
 
-static inline long _dgs_disc_gauss_dp_max_in_rho(dgs_disc_gauss_dp_t *self) {
-  long mi = 0;
-  double m = self->rho[mi];
-  for (long x = 1; x < self->two_upper_bound_minus_one;++x) {
-    if (self->rho[x] > m) {
-      mi = x;
-      m = self->rho[mi];
+/* size of one block holding ky_weight followed by ky */
+static inline size_t _dgs_disc_gauss_dp_ky_size(const dgs_disc_gauss_dp_t *self) {
+  return self->ky_cols*(sizeof(long) + self->ky_words*sizeof(uint64_t));
+}
+
+/* 64-bit probability matrix and column weights for the m values of rho[],
+   ky_cols and ky_words must be set */
+static inline void _dgs_disc_gauss_dp_init_ky(dgs_disc_gauss_dp_t *self, const double *rho, long m) {
+  self->ky_weight = (long*)calloc(_dgs_disc_gauss_dp_ky_size(self), 1);
+  if (!self->ky_weight){
+    dgs_disc_gauss_dp_clear(self);
+    dgs_die("out of memory");
+  }
+  self->ky = (uint64_t*)(self->ky_weight + self->ky_cols);
+  long double sum = 0;
+  for(long x=0; x<m; x++)
+    sum += rho[x];
+  for(long x=0; x<m; x++) {
+    long double v = floorl(ldexpl(rho[x]/sum, 64));
+    uint64_t p = (v >= ldexpl(1.0, 64)) ? UINT64_MAX : (uint64_t)v;
+    for(long j=0; j<self->ky_cols; j++) {
+      uint64_t b = (p >> (63 - j)) & 1;
+      self->ky[j*self->ky_words + x/64] |= b << (x%64);
+      self->ky_weight[j] += b;
     }
   }
-  return mi;
 }
 
-dgs_disc_gauss_dp_t *dgs_disc_gauss_dp_init(double sigma, double c, size_t tau, dgs_disc_gauss_alg_t algorithm) {
+static dgs_disc_gauss_dp_t *_dgs_disc_gauss_dp_init(double sigma, double c, size_t tau, dgs_disc_gauss_alg_t algorithm, int nocache) {
   if (sigma <= 0.0)
     dgs_die("sigma must be > 0");
   if (tau == 0)
@@ -88,11 +143,14 @@ dgs_disc_gauss_dp_t *dgs_disc_gauss_dp_init(double sigma, double c, size_t tau,
   dgs_disc_gauss_dp_t *self = (dgs_disc_gauss_dp_t*)calloc(sizeof(dgs_disc_gauss_dp_t),1);
   if (!self) dgs_die("out of memory");
 
+  self->nocache = nocache;
   self->sigma = sigma;
   self->c   = c;
   self->c_z = (long)c;
   self->c_r = self->c - ((double)self->c_z);
   self->tau = tau;
+  self->rng = dgs_rng_init(DGS_RNG_DEFAULT, NULL, 0);
+  self->rng_owned = 1;
 
   double sigma2 = sqrt(1.0/(2*log(2.0)));
   double k = sigma/sigma2;
@@ -135,7 +193,11 @@ dgs_disc_gauss_dp_t *dgs_disc_gauss_dp_init(double sigma, double c, size_t tau,
 
     if(self->c_r == 0) {
       self->call = dgs_disc_gauss_dp_call_uniform_table;
-      self->rho = (double*)malloc(sizeof(double)*self->upper_bound);
+      size_t size = sizeof(double)*self->upper_bound;
+      self->rho = (double*)_dgs_disc_gauss_dp_cache_load(self, "rho", size);
+      if (self->rho)
+        break;
+      self->rho = (double*)malloc(size);
       if (!self->rho){
         dgs_disc_gauss_dp_clear(self);
         dgs_die("out of memory");
@@ -144,9 +206,15 @@ dgs_disc_gauss_dp_t *dgs_disc_gauss_dp_init(double sigma, double c, size_t tau,
         self->rho[x] = exp( (((double)x) - self->c_r) * (((double)x) - self->c_r) * self->f);
       }
       self->rho[0]/= 2.0;
+      _dgs_disc_gauss_dp_cache_store(self, "rho", self->rho, size);
     } else {
       self->call = dgs_disc_gauss_dp_call_uniform_table_offset;
+      size_t size = sizeof(double)*self->two_upper_bound_minus_one;
+      self->rho = (double*)_dgs_disc_gauss_dp_cache_load(self, "rho", size);
+      if (self->rho)
+        break;
       _dgs_disc_gauss_dp_init_rho(self);
+      _dgs_disc_gauss_dp_cache_store(self, "rho", self->rho, size);
     }
     break;
 
@@ -194,46 +262,154 @@ dgs_disc_gauss_dp_t *dgs_disc_gauss_dp_init(double sigma, double c, size_t tau,
     self->upper_bound = upper_bound;
     self->upper_bound_minus_one = upper_bound - 1;
     self->two_upper_bound_minus_one = 2*upper_bound - 1;
-    self->B = dgs_bern_uniform_init(0);
     self->f = -1.0/(2.0*(sigma*sigma));
-    
+
+    // pad to a power of two number of buckets, so the top bits of a word pick one
+    long range = 1;
+    self->alias_bits = 0;
+    while (range < self->two_upper_bound_minus_one) {
+      range *= 2;
+      self->alias_bits++;
+    }
+    self->alias = (dgs_disc_gauss_alias_t*)_dgs_disc_gauss_dp_cache_load(self, "alias", sizeof(dgs_disc_gauss_alias_t)*range);
+    if (self->alias)
+      break;
+
     _dgs_disc_gauss_dp_init_rho(self);
-    
-    // convert rho to probabilities
+    double *rho = (double*)realloc(self->rho, sizeof(double)*range);
+    self->alias = (dgs_disc_gauss_alias_t*)calloc(range, sizeof(dgs_disc_gauss_alias_t)); // zeroed padding, the table may be cached
+    if (!rho || !self->alias){
+      dgs_disc_gauss_dp_clear(self);
+      dgs_die("out of memory");
+    }
+    self->rho = rho;
+    for(long x=self->two_upper_bound_minus_one; x<range; x++) {
+      self->rho[x] = 0.0;
+    }
+
+    // scale rho so that the buckets average 1
     double sum = 0;
-    for(long x=0; x<self->two_upper_bound_minus_one; x++) {
+    for(long x=0; x<range; x++) {
       sum += self->rho[x];
     }
-    sum = 1/sum;
-    for(long x=0; x<self->two_upper_bound_minus_one; x++) {
+    sum = range/sum;
+    for(long x=0; x<range; x++) {
       self->rho[x] *= sum;
+      self->alias[x].threshold = UINT64_MAX;
+      self->alias[x].alias = x;
+    }
+
+    // Vose's method: each bucket below 1 is topped up from one above 1, whose
+    // remainder goes back on the right list. The small list grows from the
+    // front of work[] and the large one from the back.
+    long *work = (long*)malloc(sizeof(long)*range);
+    if (!work){
+      dgs_disc_gauss_dp_clear(self);
+      dgs_die("out of memory");
     }
-    
-    // compute bias and alias
-    self->alias = (long*)malloc(sizeof(long)*self->two_upper_bound_minus_one);
-    self->bias = (dgs_bern_dp_t**)malloc(sizeof(dgs_bern_dp_t*)*self->two_upper_bound_minus_one);
-    
-    // simple robin hood strategy approximates good alias
-    // this precomputation takes ~n^2, but could be reduced by 
-    // using better data structures to compute min and max 
-    // (instead of just linear search each time)
-    double avg = 1.0 / ((double)self->two_upper_bound_minus_one);
-    long low = _dgs_disc_gauss_dp_min_in_rho(self);
-    long high;
-    while (avg - self->rho[low] > DGS_DISC_GAUSS_STRONG_EQUAL_DIFF) {
-      high = _dgs_disc_gauss_dp_max_in_rho(self);
-      
-      self->bias[low] = dgs_bern_dp_init(self->two_upper_bound_minus_one*self->rho[low]);
-      self->alias[low] = high;
-      self->rho[high] -= (avg - self->rho[low]);
-      self->rho[low] = avg;
-      
-      low = _dgs_disc_gauss_dp_min_in_rho(self);
+    long nsmall = 0, nlarge = range;
+    for(long x=0; x<range; x++) {
+      if (self->rho[x] < 1.0)
+        work[nsmall++] = x;
+      else
+        work[--nlarge] = x;
     }
-    
+    while (nsmall > 0 && nlarge < range) {
+      long low = work[--nsmall];
+      long high = work[nlarge++];
+
+      double t = ldexp(self->rho[low], 64);
+      self->alias[low].threshold = (t >= ldexp(1.0, 64)) ? UINT64_MAX : (uint64_t)t;
+      self->alias[low].alias = high;
+      self->rho[high] = (self->rho[high] + self->rho[low]) - 1.0;
+
+      if (self->rho[high] < 1.0)
+        work[nsmall++] = high;
+      else
+        work[--nlarge] = high;
+    }
+    // whatever is left is 1 up to rounding and keeps its own bucket
+    free(work);
+    _dgs_disc_gauss_dp_cache_store(self, "alias", self->alias, sizeof(dgs_disc_gauss_alias_t)*range);
+
+    free(self->rho);
+    self->rho = NULL;
     break;
   }
-  
+
+  case DGS_DISC_GAUSS_CDT: {
+    upper_bound = ceil(self->sigma*tau) + 1;
+    self->upper_bound = upper_bound;
+    self->upper_bound_minus_one = upper_bound - 1;
+    self->two_upper_bound_minus_one = 2*upper_bound - 1;
+    self->f = -1.0/(2.0*(sigma*sigma));
+
+    long m = (self->c_r == 0) ? self->upper_bound : self->two_upper_bound_minus_one;
+    self->cdt_size = m - 1;
+    _dgs_disc_gauss_dp_init_cdt_scan();
+    self->cdt = (int64_t*)_dgs_disc_gauss_dp_cache_load(self, "cdt", sizeof(int64_t)*self->cdt_size);
+    self->call = (self->c_r == 0) ? dgs_disc_gauss_dp_call_cdt : dgs_disc_gauss_dp_call_cdt_offset;
+    if (self->cdt)
+      break;
+
+    if(self->c_r == 0) {
+      self->rho = (double*)malloc(sizeof(double)*self->upper_bound);
+      if (!self->rho){
+        dgs_disc_gauss_dp_clear(self);
+        dgs_die("out of memory");
+      }
+      for(long x=0; x<self->upper_bound; x++) {
+        self->rho[x] = exp(((double)x) * ((double)x) * self->f);
+      }
+      self->rho[0]/= 2.0;
+    } else {
+      _dgs_disc_gauss_dp_init_rho(self);
+    }
+    _dgs_disc_gauss_dp_init_cdt(self, self->rho, m);
+    _dgs_disc_gauss_dp_cache_store(self, "cdt", self->cdt, sizeof(int64_t)*self->cdt_size);
+    free(self->rho);
+    self->rho = NULL;
+    break;
+  }
+
+  case DGS_DISC_GAUSS_KNUTH_YAO: {
+    upper_bound = ceil(self->sigma*tau) + 1;
+    self->upper_bound = upper_bound;
+    self->upper_bound_minus_one = upper_bound - 1;
+    self->two_upper_bound_minus_one = 2*upper_bound - 1;
+    self->B = dgs_bern_uniform_init(0);
+    self->f = -1.0/(2.0*(sigma*sigma));
+
+    long m = (self->c_r == 0) ? self->upper_bound : self->two_upper_bound_minus_one;
+    self->ky_cols = 64;
+    self->ky_words = (m + 63)/64;
+    self->ky_weight = (long*)_dgs_disc_gauss_dp_cache_load(self, "ky", _dgs_disc_gauss_dp_ky_size(self));
+    self->call = (self->c_r == 0) ? dgs_disc_gauss_dp_call_knuth_yao : dgs_disc_gauss_dp_call_knuth_yao_offset;
+    if (self->ky_weight) {
+      self->ky = (uint64_t*)(self->ky_weight + self->ky_cols);
+      break;
+    }
+
+    if(self->c_r == 0) {
+      self->rho = (double*)malloc(sizeof(double)*self->upper_bound);
+      if (!self->rho){
+        dgs_disc_gauss_dp_clear(self);
+        dgs_die("out of memory");
+      }
+      for(long x=0; x<self->upper_bound; x++) {
+        self->rho[x] = exp(((double)x) * ((double)x) * self->f);
+      }
+      self->rho[0]/= 2.0;
+    } else {
+      _dgs_disc_gauss_dp_init_rho(self);
+    }
+    _dgs_disc_gauss_dp_init_ky(self, self->rho, m);
+    _dgs_disc_gauss_dp_cache_store(self, "ky", self->ky_weight, _dgs_disc_gauss_dp_ky_size(self));
+    free(self->rho);
+    self->rho = NULL;
+    break;
+  }
+
   default:
     dgs_disc_gauss_dp_clear(self);
     dgs_die("unknown algorithm %d", algorithm);
@@ -241,14 +417,22 @@ dgs_disc_gauss_dp_t *dgs_disc_gauss_dp_init(double sigma, double c, size_t tau,
   return self;
 }
 
+dgs_disc_gauss_dp_t *dgs_disc_gauss_dp_init(double sigma, double c, size_t tau, dgs_disc_gauss_alg_t algorithm) {
+  return _dgs_disc_gauss_dp_init(sigma, c, tau, algorithm, 0);
+}
+
+dgs_disc_gauss_dp_t *dgs_disc_gauss_dp_init_nocache(double sigma, double c, size_t tau, dgs_disc_gauss_alg_t algorithm) {
+  return _dgs_disc_gauss_dp_init(sigma, c, tau, algorithm, 1);
+}
+
 long dgs_disc_gauss_dp_call_uniform_online(dgs_disc_gauss_dp_t *self) {
   long x;
   double y, z;
   double c = self->c;
   do {
-    x = self->c_z + _dgs_randomm_libc(self->two_upper_bound_minus_one) - self->upper_bound_minus_one;
+    x = self->c_z + dgs_rng_randomm(self->rng, self->two_upper_bound_minus_one) - self->upper_bound_minus_one;
     z = exp(((double)x-c)*((double)x-c)*self->f);
-    y = drand48();
+    y = dgs_rng_uniform_double(self->rng);
   } while (y >= z);
 
   return x;
@@ -258,11 +442,11 @@ long dgs_disc_gauss_dp_call_uniform_table(dgs_disc_gauss_dp_t *self) {
   long x;
   double y;
   do {
-    x = _dgs_randomm_libc(self->upper_bound);
-    y = drand48();
+    x = dgs_rng_randomm(self->rng, self->upper_bound);
+    y = dgs_rng_uniform_double(self->rng);
   } while (y >= self->rho[x]);
 
-  if(dgs_bern_uniform_call_libc(self->B))
+  if(dgs_bern_uniform_call_rng(self->B, self->rng))
     x = -x;
   return x + self->c_z;
 }
@@ -271,69 +455,271 @@ long dgs_disc_gauss_dp_call_uniform_table_offset(dgs_disc_gauss_dp_t *self) {
   long x;
   double y;
   do {
-    x = _dgs_randomm_libc(self->two_upper_bound_minus_one);
-    y = drand48();
+    x = dgs_rng_randomm(self->rng, self->two_upper_bound_minus_one);
+    y = dgs_rng_uniform_double(self->rng);
   } while (y >= self->rho[x]);
 
   return x + self->c_z - self->upper_bound_minus_one;
 }
 
 long dgs_disc_gauss_dp_call_alias(dgs_disc_gauss_dp_t *self) {
-  long x = _dgs_randomm_libc(self->two_upper_bound_minus_one);
-  if (self->bias[x]) {
-    if (!dgs_bern_dp_call(self->bias[x])) {
-      x = self->alias[x];
+  uint64_t u = dgs_rng_uniform_u64(self->rng);
+  const dgs_disc_gauss_alias_t *a = self->alias + (u >> (64 - self->alias_bits));
+  long x = ((u << self->alias_bits) < a->threshold) ? (long)(a - self->alias) : (long)a->alias;
+  return x + self->c_z - self->upper_bound_minus_one;
+}
+
+/* number of entries of cdt[] which are <= r, without branches or early exit */
+static long _dgs_disc_gauss_dp_cdt_scan_scalar(const int64_t *cdt, long size, int64_t r) {
+  long x = 0;
+  for(long i=0; i<size; i++)
+    x += (r >= cdt[i]);
+  return x;
+}
+
+#ifdef DGS_GAUSS_DP_X86
+
+/* the same count four entries at a time: cdt[] and r are non-negative, so the signed compare
+   cdt[i] > r is exact and every lane it sets counts one entry which is not <= r */
+__attribute__((target("avx2")))
+static long _dgs_disc_gauss_dp_cdt_scan_avx2(const int64_t *cdt, long size, int64_t r) {
+  const __m256i rv = _mm256_set1_epi64x(r);
+  __m256i acc = _mm256_setzero_si256();
+  long i = 0;
+  for(; i+4<=size; i+=4)
+    acc = _mm256_add_epi64(acc, _mm256_cmpgt_epi64(_mm256_loadu_si256((const __m256i*)(cdt+i)), rv));
+  int64_t lanes[4];
+  _mm256_storeu_si256((__m256i*)lanes, acc);
+  long x = i + lanes[0] + lanes[1] + lanes[2] + lanes[3];
+  for(; i<size; i++)
+    x += (r >= cdt[i]);
+  return x;
+}
+
+/* eight entries at a time, counting the compare mask bits */
+__attribute__((target("avx512f")))
+static long _dgs_disc_gauss_dp_cdt_scan_avx512(const int64_t *cdt, long size, int64_t r) {
+  const __m512i rv = _mm512_set1_epi64(r);
+  long x = 0;
+  long i = 0;
+  for(; i+8<=size; i+=8)
+    x += __builtin_popcount(_mm512_cmple_epi64_mask(_mm512_loadu_si512((const void*)(cdt+i)), rv));
+  for(; i<size; i++)
+    x += (r >= cdt[i]);
+  return x;
+}
+
+#endif
+
+typedef long (*_dgs_disc_gauss_dp_cdt_scan_t)(const int64_t *cdt, long size, int64_t r);
+
+static _dgs_disc_gauss_dp_cdt_scan_t _dgs_disc_gauss_dp_cdt_scan = _dgs_disc_gauss_dp_cdt_scan_scalar;
+static pthread_once_t _dgs_disc_gauss_dp_cdt_scan_once = PTHREAD_ONCE_INIT;
+
+/* run once, by whichever thread initialises the first CDT sampler */
+static void _dgs_disc_gauss_dp_cdt_scan_select(void) {
+#ifdef DGS_GAUSS_DP_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f"))
+    _dgs_disc_gauss_dp_cdt_scan = _dgs_disc_gauss_dp_cdt_scan_avx512;
+  else if (__builtin_cpu_supports("avx2"))
+    _dgs_disc_gauss_dp_cdt_scan = _dgs_disc_gauss_dp_cdt_scan_avx2;
+#endif
+}
+
+static void _dgs_disc_gauss_dp_init_cdt_scan(void) {
+  pthread_once(&_dgs_disc_gauss_dp_cdt_scan_once, _dgs_disc_gauss_dp_cdt_scan_select);
+}
+
+long dgs_disc_gauss_dp_call_cdt(dgs_disc_gauss_dp_t *self) {
+  uint64_t u = dgs_rng_uniform_u64(self->rng);
+  long x = _dgs_disc_gauss_dp_cdt_scan(self->cdt, self->cdt_size, (int64_t)(u >> 1));
+  long s = -(long)(u & 1);
+  return ((x ^ s) - s) + self->c_z;
+}
+
+long dgs_disc_gauss_dp_call_cdt_offset(dgs_disc_gauss_dp_t *self) {
+  uint64_t u = dgs_rng_uniform_u64(self->rng);
+  long x = _dgs_disc_gauss_dp_cdt_scan(self->cdt, self->cdt_size, (int64_t)(u >> 1));
+  return x + self->c_z - self->upper_bound_minus_one;
+}
+
+/* walk the DDG tree: at depth j there are ky_weight[j] leaves, d indexes the node we are at */
+static inline long _dgs_disc_gauss_dp_ky_walk(dgs_disc_gauss_dp_t *self) {
+  while (1) {
+    uint64_t d = 0;
+    for(long j=0; j<self->ky_cols; j++) {
+      d = 2*d + dgs_bern_uniform_call_rng(self->B, self->rng);
+      if (d < (uint64_t)self->ky_weight[j]) {
+        /* the d-th one of column j is our leaf */
+        const uint64_t *col = self->ky + j*self->ky_words;
+        long w = 0;
+        uint64_t c;
+        while (d >= (c = __builtin_popcountll(col[w]))) {
+          d -= c;
+          w++;
+        }
+        uint64_t word = col[w];
+        for(; d>0; d--)
+          word &= word - 1;
+        return 64*w + __builtin_ctzll(word);
+      }
+      d -= self->ky_weight[j];
     }
+    /* the truncated probabilities sum to less than one, start over */
   }
-  
-  return x + self->c_z - self->upper_bound_minus_one;
+}
+
+long dgs_disc_gauss_dp_call_knuth_yao(dgs_disc_gauss_dp_t *self) {
+  long x = _dgs_disc_gauss_dp_ky_walk(self);
+  if(dgs_bern_uniform_call_rng(self->B, self->rng))
+    x = -x;
+  return x + self->c_z;
+}
+
+long dgs_disc_gauss_dp_call_knuth_yao_offset(dgs_disc_gauss_dp_t *self) {
+  return _dgs_disc_gauss_dp_ky_walk(self) + self->c_z - self->upper_bound_minus_one;
 }
 
 long dgs_disc_gauss_dp_call_uniform_logtable(dgs_disc_gauss_dp_t *self) {
   long x;
   do {
-    x = _dgs_randomm_libc(self->two_upper_bound_minus_one) - self->upper_bound_minus_one;
-  } while (dgs_bern_exp_dp_call(self->Bexp, x*x) == 0);
+    x = dgs_rng_randomm(self->rng, self->two_upper_bound_minus_one) - self->upper_bound_minus_one;
+  } while (dgs_bern_exp_dp_call(self->Bexp, x*x, self->rng) == 0);
   return x + self->c_z;
 }
 
 long dgs_disc_gauss_dp_call_sigma2_logtable(dgs_disc_gauss_dp_t *self) {
   long x, y, z;
+  unsigned long s;
   long k = self->k;
 
   do {
     do {
-      x = dgs_disc_gauss_sigma2p_dp_call(self->D2);
-      y = _dgs_randomm_libc(self->k);
-    } while (dgs_bern_exp_dp_call(self->Bexp, y*(y + 2*k*x)) == 0);
+      x = dgs_disc_gauss_sigma2p_dp_call(self->D2, self->rng);
+      y = dgs_rng_randomm(self->rng, self->k);
+    } while (dgs_bern_exp_dp_call(self->Bexp, y*(y + 2*k*x), self->rng) == 0);
     z = k*x + y;
-    if (!z) {
-      if (dgs_bern_uniform_call_libc(self->B))
-        break;
-    } else {
-      break;
-    }
-  } while (1);
-  if(dgs_bern_uniform_call_libc(self->B))
+    /* one bit to keep half of the zeros, one for the sign */
+    s = dgs_bern_uniform_bits_rng(self->B, self->rng, 2);
+  } while (!z && !(s & 1));
+  if (s & 2)
     z = -z;
   return z + self->c_z;
 }
 
+/*
+ * Bulk sampling
+ */
+
+/* One round of DGS_DISC_GAUSS_UNIFORM_TABLE for at most DGS_DISC_GAUSS_BATCH samples */
+static void _dgs_disc_gauss_dp_call_n_uniform_table(dgs_disc_gauss_dp_t *self, long *out, size_t n) {
+  long x[DGS_DISC_GAUSS_BATCH];
+  double y[DGS_DISC_GAUSS_BATCH];
+  unsigned char accept[DGS_DISC_GAUSS_BATCH];
+  const double *rho = self->rho;
+  size_t filled = 0;
+
+  while (filled < n) {
+    size_t m = n - filled;
+    for(size_t i=0; i<m; i++) {
+      x[i] = dgs_rng_randomm(self->rng, self->upper_bound);
+      y[i] = dgs_rng_uniform_double(self->rng);
+    }
+    for(size_t i=0; i<m; i++)
+      accept[i] = y[i] < rho[x[i]];
+    for(size_t i=0; i<m; i++) {
+      out[filled] = x[i];
+      filled += accept[i];
+    }
+  }
+
+  /* signs, 64 at a time */
+  for(size_t i=0; i<n; i+=64) {
+    uint64_t bits = dgs_rng_uniform_u64(self->rng);
+    size_t m = (n - i < 64) ? n - i : 64;
+    for(size_t j=0; j<m; j++) {
+      long s = -(long)((bits >> j) & 1);
+      out[i+j] = ((out[i+j] ^ s) - s) + self->c_z;
+    }
+  }
+}
+
+/* At most DGS_DISC_GAUSS_BATCH samples, dispatching on the algorithm once */
+static void _dgs_disc_gauss_dp_call_batch(dgs_disc_gauss_dp_t *self, long *out, size_t n) {
+  if (self->call == dgs_disc_gauss_dp_call_uniform_table) {
+    _dgs_disc_gauss_dp_call_n_uniform_table(self, out, n);
+  } else if (self->call == dgs_disc_gauss_dp_call_uniform_table_offset) {
+    for(size_t i=0; i<n; i++)
+      out[i] = dgs_disc_gauss_dp_call_uniform_table_offset(self);
+  } else if (self->call == dgs_disc_gauss_dp_call_uniform_online) {
+    for(size_t i=0; i<n; i++)
+      out[i] = dgs_disc_gauss_dp_call_uniform_online(self);
+  } else if (self->call == dgs_disc_gauss_dp_call_uniform_logtable) {
+    for(size_t i=0; i<n; i++)
+      out[i] = dgs_disc_gauss_dp_call_uniform_logtable(self);
+  } else if (self->call == dgs_disc_gauss_dp_call_sigma2_logtable) {
+    for(size_t i=0; i<n; i++)
+      out[i] = dgs_disc_gauss_dp_call_sigma2_logtable(self);
+  } else if (self->call == dgs_disc_gauss_dp_call_alias) {
+    for(size_t i=0; i<n; i++)
+      out[i] = dgs_disc_gauss_dp_call_alias(self);
+  } else if (self->call == dgs_disc_gauss_dp_call_cdt) {
+    for(size_t i=0; i<n; i++)
+      out[i] = dgs_disc_gauss_dp_call_cdt(self);
+  } else if (self->call == dgs_disc_gauss_dp_call_cdt_offset) {
+    for(size_t i=0; i<n; i++)
+      out[i] = dgs_disc_gauss_dp_call_cdt_offset(self);
+  } else if (self->call == dgs_disc_gauss_dp_call_knuth_yao) {
+    for(size_t i=0; i<n; i++)
+      out[i] = dgs_disc_gauss_dp_call_knuth_yao(self);
+  } else if (self->call == dgs_disc_gauss_dp_call_knuth_yao_offset) {
+    for(size_t i=0; i<n; i++)
+      out[i] = dgs_disc_gauss_dp_call_knuth_yao_offset(self);
+  } else {
+    for(size_t i=0; i<n; i++)
+      out[i] = self->call(self);
+  }
+}
+
+void dgs_disc_gauss_dp_call_n(dgs_disc_gauss_dp_t *self, long *out, size_t n) {
+  for(size_t i=0; i<n; i+=DGS_DISC_GAUSS_BATCH) {
+    size_t m = (n - i < DGS_DISC_GAUSS_BATCH) ? n - i : DGS_DISC_GAUSS_BATCH;
+    _dgs_disc_gauss_dp_call_batch(self, out + i, m);
+  }
+}
+
+#define _DGS_DISC_GAUSS_DP_CALL_N_NARROW(name, T)                        \
+void name(dgs_disc_gauss_dp_t *self, T *out, size_t n) {                \
+  long tmp[DGS_DISC_GAUSS_BATCH];                                       \
+  for(size_t i=0; i<n; i+=DGS_DISC_GAUSS_BATCH) {                       \
+    size_t m = (n - i < DGS_DISC_GAUSS_BATCH) ? n - i : DGS_DISC_GAUSS_BATCH; \
+    _dgs_disc_gauss_dp_call_batch(self, tmp, m);                        \
+    for(size_t j=0; j<m; j++)                                           \
+      out[i+j] = (T)tmp[j];                                             \
+  }                                                                     \
+}
+
+_DGS_DISC_GAUSS_DP_CALL_N_NARROW(dgs_disc_gauss_dp_call_n_int32, int32_t)
+_DGS_DISC_GAUSS_DP_CALL_N_NARROW(dgs_disc_gauss_dp_call_n_int16, int16_t)
+
+void dgs_disc_gauss_dp_set_rng(dgs_disc_gauss_dp_t *self, dgs_rng_t *rng) {
+  assert(self != NULL && rng != NULL);
+  if (self->rng_owned) dgs_rng_clear(self->rng);
+  self->rng = rng;
+  self->rng_owned = 0;
+}
 
 void dgs_disc_gauss_dp_clear(dgs_disc_gauss_dp_t *self) {
   assert(self != NULL);
+  if (self->rng && self->rng_owned) dgs_rng_clear(self->rng);
   if (self->B) dgs_bern_uniform_clear(self->B);
   if (self->Bexp) dgs_bern_exp_dp_clear(self->Bexp);
-  if (self->rho) free(self->rho);
-  if (self->alias) free(self->alias);
-  if (self->bias) {
-    for(long x=0; x<self->two_upper_bound_minus_one; x++) {
-      if (self->bias[x]) {
-        free(self->bias[x]);
-      }
-    }
-    free(self->bias);
-  }
+  if (self->rho && !dgs_cache_contains(&self->cache, self->rho)) free(self->rho);
+  if (self->alias && !dgs_cache_contains(&self->cache, self->alias)) free(self->alias);
+  if (self->cdt && !dgs_cache_contains(&self->cache, self->cdt)) free(self->cdt);
+  if (self->ky_weight && !dgs_cache_contains(&self->cache, self->ky_weight)) free(self->ky_weight); // ky lives in the same block
+  dgs_cache_clear(&self->cache);
   
   free(self);
 }
@@ -32,10 +32,19 @@
 
 #include "dgs.h"
 #include <assert.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <limits.h>
 #include <math.h>
 
+/* the low 64 bits of op */
+static inline uint64_t _dgs_disc_gauss_mp_get_u64(const mpz_t op) {
+  uint64_t r = 0;
+  for(int i=0; i*GMP_NUMB_BITS < 64; i++)
+    r |= ((uint64_t)mpz_getlimbn(op, i)) << (i*GMP_NUMB_BITS);
+  return r;
+}
+
 /** SIGMA2 **/
 
 static void sigma2_init(mpfr_t sigma2, int prec) {
@@ -47,50 +56,177 @@ static void sigma2_init(mpfr_t sigma2, int prec) {
   mpfr_sqrt(sigma2, sigma2, MPFR_RNDN); //σ₂ = sqrt(1/(2·log₂ 2))
 }
 
-static inline void _dgs_disc_gauss_mp_init_rho(dgs_disc_gauss_mp_t *self, const mpfr_prec_t prec) {
-  self->rho = (mpfr_t*)malloc(sizeof(mpfr_t)*mpz_get_ui(self->two_upper_bound_minus_one));
+/* key of the table name of this sampler in the on-disk cache, σ and c_r are
+   written out exactly in base 16 */
+static inline void _dgs_disc_gauss_mp_cache_key(char *key, const dgs_disc_gauss_mp_t *self, const char *name, const mpfr_prec_t prec) {
+  mpfr_exp_t e_sigma, e_c;
+  char *sigma = mpfr_get_str(NULL, &e_sigma, 16, 0, self->sigma, MPFR_RNDN);
+  char *c = mpfr_get_str(NULL, &e_c, 16, 0, self->c_r, MPFR_RNDN);
+  snprintf(key, DGS_CACHE_KEY_SIZE, "mp %s alg=%d sigma=%s@%ld c_r=%s@%ld tau=%zu prec=%ld limb=%d",
+           name, (int)self->algorithm, sigma, (long)e_sigma, c, (long)e_c, self->tau, (long)prec, GMP_NUMB_BITS);
+  mpfr_free_str(c);
+  mpfr_free_str(sigma);
+}
+
+/* the cached table name of this sampler, NULL on a miss */
+static inline const void *_dgs_disc_gauss_mp_cache_load(dgs_disc_gauss_mp_t *self, const char *name, const mpfr_prec_t prec, size_t size) {
+  char key[DGS_CACHE_KEY_SIZE];
+  _dgs_disc_gauss_mp_cache_key(key, self, name, prec);
+  return dgs_cache_load(&self->cache, key, size);
+}
+
+static inline void _dgs_disc_gauss_mp_cache_store(dgs_disc_gauss_mp_t *self, const char *name, const mpfr_prec_t prec, const void *data, size_t size) {
+  char key[DGS_CACHE_KEY_SIZE];
+  _dgs_disc_gauss_mp_cache_key(key, self, name, prec);
+  dgs_cache_store(key, data, size);
+}
+
+/* rho[i] = exp((x0+i-c_r)²·f) for i = 0,...,m-1, on all threads for large
+   tables, each with its own temporary */
+static inline void _dgs_disc_gauss_mp_init_rho_range(dgs_disc_gauss_mp_t *self, long x0, long m, const mpfr_prec_t prec) {
+  self->rho = (mpfr_t*)malloc(sizeof(mpfr_t)*m);
   if (!self->rho){
     dgs_disc_gauss_mp_clear(self);
     dgs_die("out of memory");
   }
 
-  mpfr_t x_;
-  mpfr_init2(x_, prec);
+  const int parallel = (m*prec >= DGS_MP_PARALLEL_MIN_WORK) && mpfr_buildopt_tls_p();
+  #pragma omp parallel if(parallel)
+  {
+    mpfr_t x_;
+    mpfr_init2(x_, prec);
+    #pragma omp for schedule(static)
+    for(long i=0; i<m; i++) {
+      mpfr_set_si(x_, x0+i, MPFR_RNDN);
+      mpfr_sub(x_, x_, self->c_r, MPFR_RNDN);
+      mpfr_sqr(x_, x_, MPFR_RNDN);
+      mpfr_mul(x_, x_, self->f, MPFR_RNDN);
+      mpfr_init2(self->rho[i], prec);
+      mpfr_exp(self->rho[i], x_, MPFR_RNDN);
+    }
+    mpfr_clear(x_);
+  }
+}
+
+/* rho over -(upper_bound-1),...,upper_bound-1 */
+static inline void _dgs_disc_gauss_mp_init_rho(dgs_disc_gauss_mp_t *self, const mpfr_prec_t prec) {
   long absmax = mpz_get_ui(self->upper_bound) - 1;
-  for(long x=-absmax; x<=absmax; x++) {
-    mpfr_set_si(x_, x, MPFR_RNDN);
-    mpfr_sub(x_, x_, self->c_r, MPFR_RNDN);
-    mpfr_sqr(x_, x_, MPFR_RNDN);
-    mpfr_mul(x_, x_, self->f, MPFR_RNDN);
-    mpfr_exp(x_, x_, MPFR_RNDN);
-    mpfr_init2(self->rho[x+absmax], prec);
-    mpfr_set(self->rho[x+absmax], x_, MPFR_RNDN);
+  _dgs_disc_gauss_mp_init_rho_range(self, -absmax, 2*absmax+1, prec);
+}
+
+/* replace the m entries of self->rho by self->rho_u128 */
+static inline void _dgs_disc_gauss_mp_init_rho_u128(dgs_disc_gauss_mp_t *self, unsigned long m, const mpfr_prec_t prec) {
+  self->rho_u128 = (dgs_u128_t*)malloc(sizeof(dgs_u128_t)*m);
+  if (!self->rho_u128){
+    dgs_disc_gauss_mp_clear(self);
+    dgs_die("out of memory");
+  }
+  for(unsigned long x=0; x<m; x++) {
+    self->rho_u128[x] = dgs_u128_set_mpfr(self->rho[x]);
+    mpfr_clear(self->rho[x]);
   }
-  mpfr_clear(x_);
+  free(self->rho);
+  self->rho = NULL;
+  _dgs_disc_gauss_mp_cache_store(self, "rho", prec, self->rho_u128, sizeof(dgs_u128_t)*m);
 }
 
-static inline long _dgs_disc_gauss_mp_min_in_rho(dgs_disc_gauss_mp_t *self, long range) {
-  long mi = 0;
-  mpfr_t* m = &(self->rho[mi]);
-  for (long x = 1; x < range;++x) {
-    if (mpfr_cmp(self->rho[x], *m) < 0) {
-      mi = x;
-      m = &(self->rho[mi]);
-    }
+/* cdt[i] = 2^bits·(ρ(0)+...+ρ(i))/Σρ for the m values of self->rho, which is
+   freed, cdt_limbs must be set */
+static inline void _dgs_disc_gauss_mp_init_cdt(dgs_disc_gauss_mp_t *self, long m, const mpfr_prec_t prec) {
+  const mp_size_t limbs = self->cdt_limbs;
+  self->cdt = (mp_limb_t*)calloc((m > 1 ? m - 1 : 1)*limbs, sizeof(mp_limb_t));
+  if (!self->cdt){
+    dgs_disc_gauss_mp_clear(self);
+    dgs_die("out of memory");
+  }
+
+  mpfr_t sum, cum;
+  mpz_t v, vmax;
+  mpfr_init2(sum, prec);
+  mpfr_init2(cum, prec);
+  mpz_init(v);
+  mpz_init(vmax);
+  mpz_setbit(vmax, limbs*GMP_NUMB_BITS);
+  mpz_sub_ui(vmax, vmax, 1); // 2^bits - 1
+
+  mpfr_set_ui(sum, 0, MPFR_RNDN);
+  for(long x=0; x<m; x++)
+    mpfr_add(sum, sum, self->rho[x], MPFR_RNDN);
+
+  mpfr_set_ui(cum, 0, MPFR_RNDN);
+  for(long x=0; x<m-1; x++) {
+    mpfr_add(cum, cum, self->rho[x], MPFR_RNDN);
+    mpfr_div(self->y, cum, sum, MPFR_RNDN);
+    mpfr_mul_2ui(self->y, self->y, limbs*GMP_NUMB_BITS, MPFR_RNDN);
+    mpfr_get_z(v, self->y, MPFR_RNDN);
+    if (mpz_cmp(v, vmax) > 0)
+      mpz_set(v, vmax);
+    for(mp_size_t j=0; j<limbs; j++)
+      self->cdt[x*limbs + j] = mpz_getlimbn(v, j);
   }
-  return mi;
+
+  _dgs_disc_gauss_mp_cache_store(self, "cdt", prec, self->cdt, sizeof(mp_limb_t)*self->cdt_size*limbs);
+
+  for(long x=0; x<m; x++)
+    mpfr_clear(self->rho[x]);
+  free(self->rho);
+  self->rho = NULL;
+
+  mpz_clear(vmax);
+  mpz_clear(v);
+  mpfr_clear(cum);
+  mpfr_clear(sum);
 }
 
-static inline long _dgs_disc_gauss_mp_max_in_rho(dgs_disc_gauss_mp_t *self, long range) {
-  long mi = 0;
-  mpfr_t* m = &(self->rho[mi]);
-  for (long x = 1; x < range;++x) {
-    if (mpfr_cmp(self->rho[x], *m) > 0) {
-      mi = x;
-      m = &(self->rho[mi]);
+/* size of one block holding ky_weight followed by ky */
+static inline size_t _dgs_disc_gauss_mp_ky_size(const dgs_disc_gauss_mp_t *self) {
+  return self->ky_cols*(sizeof(long) + self->ky_words*sizeof(uint64_t));
+}
+
+/* prec-bit probability matrix and column weights for the m values of
+   self->rho, which is freed, ky_cols and ky_words must be set */
+static inline void _dgs_disc_gauss_mp_init_ky(dgs_disc_gauss_mp_t *self, long m, const mpfr_prec_t prec) {
+  self->ky_weight = (long*)calloc(_dgs_disc_gauss_mp_ky_size(self), 1);
+  if (!self->ky_weight){
+    dgs_disc_gauss_mp_clear(self);
+    dgs_die("out of memory");
+  }
+  self->ky = (uint64_t*)(self->ky_weight + self->ky_cols);
+
+  mpfr_t sum;
+  mpz_t v;
+  mpfr_init2(sum, prec);
+  mpz_init(v);
+
+  mpfr_set_ui(sum, 0, MPFR_RNDN);
+  for(long x=0; x<m; x++)
+    mpfr_add(sum, sum, self->rho[x], MPFR_RNDN);
+
+  for(long x=0; x<m; x++) {
+    mpfr_div(self->y, self->rho[x], sum, MPFR_RNDN);
+    mpfr_mul_2ui(self->y, self->y, prec, MPFR_RNDN);
+    mpfr_get_z(v, self->y, MPFR_RNDD);
+    if (mpz_sizeinbase(v, 2) > (size_t)prec) { // p = 1
+      mpz_set_ui(v, 0);
+      mpz_setbit(v, prec);
+      mpz_sub_ui(v, v, 1);
+    }
+    for(long j=0; j<self->ky_cols; j++) {
+      uint64_t b = mpz_tstbit(v, prec - 1 - j);
+      self->ky[j*self->ky_words + x/64] |= b << (x%64);
+      self->ky_weight[j] += b;
     }
   }
-  return mi;
+
+  _dgs_disc_gauss_mp_cache_store(self, "ky", prec, self->ky_weight, _dgs_disc_gauss_mp_ky_size(self));
+
+  for(long x=0; x<m; x++)
+    mpfr_clear(self->rho[x]);
+  free(self->rho);
+  self->rho = NULL;
+
+  mpz_clear(v);
+  mpfr_clear(sum);
 }
 
 dgs_disc_gauss_sigma2p_t *dgs_disc_gauss_sigma2p_init() {
@@ -100,48 +236,77 @@ dgs_disc_gauss_sigma2p_t *dgs_disc_gauss_sigma2p_init() {
   return self;
 }
 
+/*
+  D_{σ₂,0} reads a bit, 0 to return 0. Level i >= 1 then reads 2i-2 zeros,
+  starting over on a one, and a stop bit, 0 to return i and 1 to go on to level
+  i+1. So 0 gives 0, 10 gives 1 and 110 starts level 2 with the first of its
+  zeros read, all found by one count of leading ones. From there the zeros and
+  the stop bit of a level are read as one block of at most a word, the zeros
+  checked with one mask compare.
+*/
+
 void dgs_disc_gauss_sigma2p_mp_call(mpz_t rop, dgs_disc_gauss_sigma2p_t *self, gmp_randstate_t state) {
+  const size_t length = self->B->length;
   while(1) {
-    if (!dgs_bern_uniform_call(self->B, state)) {
-      mpz_set_ui(rop, 0);
+    unsigned long r = dgs_bern_uniform_ones(self->B, state);
+    if (__DGS_LIKELY(r < 2)) {
+      mpz_set_ui(rop, r);
       return;
     }
+    if (r > 2)
+      continue;
+
+    size_t zeros = 1;
     int dobreak = 0;
-    for(unsigned long i=1; ;i++) {
-      for(size_t j=0; j<2*i-2; j++) {
-        if(dgs_bern_uniform_call(self->B, state)) {
+    for(unsigned long i=2; ; i++) {
+      size_t left = zeros;
+      for(; left >= length; left -= length) {
+        if (dgs_bern_uniform_bits(self->B, state, length)) {
           dobreak = 1;
           break;
         }
       }
-      if (__DGS_LIKELY(dobreak))
+      if (__DGS_UNLIKELY(dobreak))
+        break;
+      const unsigned long w = dgs_bern_uniform_bits(self->B, state, left + 1);
+      if (left && (w & __DGS_LSB_BITMASK(left)))
         break;
-      if (!dgs_bern_uniform_call(self->B, state)) {
+      if (!(w >> left)) {
         mpz_set_ui(rop, i);
         return;
       }
+      zeros = 2*i;
     }
   }
 }
 
-long dgs_disc_gauss_sigma2p_dp_call(dgs_disc_gauss_sigma2p_t *self) {
+long dgs_disc_gauss_sigma2p_dp_call(dgs_disc_gauss_sigma2p_t *self, dgs_rng_t *rng) {
+  const size_t length = self->B->length;
   while(1) {
-    if (!dgs_bern_uniform_call_libc(self->B)) {
-      return 0;
-    }
+    unsigned long r = dgs_bern_uniform_ones_rng(self->B, rng);
+    if (__DGS_LIKELY(r < 2))
+      return r;
+    if (r > 2)
+      continue;
+
+    size_t zeros = 1;
     int dobreak = 0;
-    for(unsigned long i=1; ;i++) {
-      for(size_t j=0; j<2*i-2; j++) {
-        if(dgs_bern_uniform_call_libc(self->B)) {
+    for(unsigned long i=2; ; i++) {
+      size_t left = zeros;
+      for(; left >= length; left -= length) {
+        if (dgs_bern_uniform_bits_rng(self->B, rng, length)) {
           dobreak = 1;
           break;
         }
       }
-      if (__DGS_LIKELY(dobreak))
+      if (__DGS_UNLIKELY(dobreak))
+        break;
+      const unsigned long w = dgs_bern_uniform_bits_rng(self->B, rng, left + 1);
+      if (left && (w & __DGS_LSB_BITMASK(left)))
         break;
-      if (!dgs_bern_uniform_call_libc(self->B)) {
+      if (!(w >> left))
         return i;
-      }
+      zeros = 2*i;
     }
   }
 }
@@ -268,30 +433,23 @@ dgs_disc_gauss_mp_t *dgs_disc_gauss_mp_init(const mpfr_t sigma, const mpfr_t c,
     self->B = dgs_bern_uniform_init(0);
     _dgs_disc_gauss_mp_init_f(self->f, sigma);
 
+    /* at low precision only rho_u128 is kept, and it may be cached */
+    const unsigned long m = mpfr_zero_p(self->c_r) ? mpz_get_ui(self->upper_bound) : mpz_get_ui(self->two_upper_bound_minus_one);
+    if (prec <= DGS_MP_U128_MAX_PREC) {
+      self->call = mpfr_zero_p(self->c_r) ? dgs_disc_gauss_mp_call_uniform_table_u128 : dgs_disc_gauss_mp_call_uniform_table_offset_u128;
+      self->rho_u128 = (dgs_u128_t*)_dgs_disc_gauss_mp_cache_load(self, "rho", prec, sizeof(dgs_u128_t)*m);
+      if (self->rho_u128)
+        break;
+    }
+
     if (mpfr_zero_p(self->c_r)) { /* c is an integer */
       self->call = dgs_disc_gauss_mp_call_uniform_table;
       if (mpz_cmp_ui(self->upper_bound, ULONG_MAX/sizeof(mpfr_t))>0){
         dgs_disc_gauss_mp_clear(self);
         dgs_die("integer overflow");
       }
-      self->rho = (mpfr_t*)malloc(sizeof(mpfr_t)*mpz_get_ui(self->upper_bound));
-      if (!self->rho){
-        dgs_disc_gauss_mp_clear(self);
-        dgs_die("out of memory");
-      }
-
-      mpfr_t x_;
-      mpfr_init2(x_, prec);
-      for(unsigned long x=0; x<mpz_get_ui(self->upper_bound); x++) {
-        mpfr_set_ui(x_, x, MPFR_RNDN);
-        mpfr_sqr(x_, x_, MPFR_RNDN);
-        mpfr_mul(x_, x_, self->f, MPFR_RNDN);
-        mpfr_exp(x_, x_, MPFR_RNDN);
-        mpfr_init2(self->rho[x], prec);
-        mpfr_set(self->rho[x], x_, MPFR_RNDN);
-      }
+      _dgs_disc_gauss_mp_init_rho_range(self, 0, mpz_get_ui(self->upper_bound), prec);
       mpfr_div_ui(self->rho[0],self->rho[0], 2, MPFR_RNDN);
-      mpfr_clear(x_);
 
     } else { /* c is not an integer, we need a bigger table as our nice symmetry is lost */
       self->call = dgs_disc_gauss_mp_call_uniform_table_offset;
@@ -302,6 +460,11 @@ dgs_disc_gauss_mp_t *dgs_disc_gauss_mp_init(const mpfr_t sigma, const mpfr_t c,
       // we need a bigger table
       _dgs_disc_gauss_mp_init_rho(self, prec);
     }
+
+    if (prec <= DGS_MP_U128_MAX_PREC) {
+      _dgs_disc_gauss_mp_init_rho_u128(self, m, prec);
+      self->call = mpfr_zero_p(self->c_r) ? dgs_disc_gauss_mp_call_uniform_table_u128 : dgs_disc_gauss_mp_call_uniform_table_offset_u128;
+    }
     break;
   }
 
@@ -358,69 +521,173 @@ dgs_disc_gauss_mp_t *dgs_disc_gauss_mp_init(const mpfr_t sigma, const mpfr_t c,
                                         self->two_upper_bound_minus_one,
                                         self->sigma, self->tau);
     _dgs_disc_gauss_mp_init_f(self->f, sigma);
-    
+
     self->call = dgs_disc_gauss_mp_call_alias;
-    if (mpz_cmp_ui(self->two_upper_bound_minus_one, ULONG_MAX/sizeof(mpfr_t)) > 0){
+    if (mpz_cmp_ui(self->two_upper_bound_minus_one, INT32_MAX/2) > 0){
       dgs_disc_gauss_mp_clear(self);
       dgs_die("integer overflow");
     }
+    // pad to a power of two number of buckets, so the top bits of a word pick one
+    long n = mpz_get_ui(self->two_upper_bound_minus_one);
+    long range = 1;
+    self->alias_bits = 0;
+    while (range < n) {
+      range *= 2;
+      self->alias_bits++;
+    }
+    self->alias = (dgs_disc_gauss_alias_t*)_dgs_disc_gauss_mp_cache_load(self, "alias", prec, sizeof(dgs_disc_gauss_alias_t)*range);
+    if (self->alias)
+      break;
+
     // we'll use the big table
     _dgs_disc_gauss_mp_init_rho(self, prec);
-    
-    // convert rho to probabilities
+    mpfr_t *rho = (mpfr_t*)realloc(self->rho, sizeof(mpfr_t)*range);
+    self->alias = (dgs_disc_gauss_alias_t*)calloc(range, sizeof(dgs_disc_gauss_alias_t)); // zeroed padding, the table may be cached
+    if (!rho || !self->alias){
+      dgs_disc_gauss_mp_clear(self);
+      dgs_die("out of memory");
+    }
+    self->rho = rho;
+    for(long x=n; x<range; x++) {
+      mpfr_init2(self->rho[x], prec);
+      mpfr_set_ui(self->rho[x], 0, MPFR_RNDN);
+    }
+
+    // scale rho so that the buckets average 1
     mpfr_set_d(self->y, 0.0, MPFR_RNDN);
-    mpfr_set_d(self->z, 1.0, MPFR_RNDN);
-    long range = mpz_get_ui(self->two_upper_bound_minus_one);
     for(long x=0; x<range; x++) {
       mpfr_add(self->y, self->y,self->rho[x], MPFR_RNDN);
     }
-    mpfr_div(self->y, self->z, self->y, MPFR_RNDN);
-    
+    mpfr_ui_div(self->y, range, self->y, MPFR_RNDN);
+
     for(long x=0; x<range; x++) {
       mpfr_mul(self->rho[x], self->rho[x], self->y, MPFR_RNDN);
+      self->alias[x].threshold = UINT64_MAX;
+      self->alias[x].alias = x;
     }
-    
-    // compute bias and alias
-    self->alias = (mpz_t*)calloc(range, sizeof(mpz_t));
-    if (!self->alias){
+
+    // Vose's method, see dgs_gauss_dp.c
+    long *work = (long*)malloc(sizeof(long)*range);
+    if (!work){
       dgs_disc_gauss_mp_clear(self);
       dgs_die("out of memory");
     }
-    
-    self->bias = (dgs_bern_mp_t**)calloc(range, sizeof(dgs_bern_mp_t*));
-    if (!self->bias){
+    long nsmall = 0, nlarge = range;
+    for(long x=0; x<range; x++) {
+      if (mpfr_cmp_ui(self->rho[x], 1) < 0)
+        work[nsmall++] = x;
+      else
+        work[--nlarge] = x;
+    }
+
+    mpz_t t;
+    mpz_init(t);
+    while (nsmall > 0 && nlarge < range) {
+      long low = work[--nsmall];
+      long high = work[nlarge++];
+
+      mpfr_mul_2ui(self->z, self->rho[low], 64, MPFR_RNDN);
+      mpfr_get_z(t, self->z, MPFR_RNDD); // threshold = ⌊2^64·rho[low]⌋
+      self->alias[low].threshold = (mpz_sizeinbase(t, 2) > 64) ? UINT64_MAX : _dgs_disc_gauss_mp_get_u64(t);
+      self->alias[low].alias = high;
+      mpfr_add(self->rho[high], self->rho[high], self->rho[low], MPFR_RNDN);
+      mpfr_sub_ui(self->rho[high], self->rho[high], 1, MPFR_RNDN);
+
+      if (mpfr_cmp_ui(self->rho[high], 1) < 0)
+        work[nsmall++] = high;
+      else
+        work[--nlarge] = high;
+    }
+    // whatever is left is 1 up to rounding and keeps its own bucket
+    mpz_clear(t);
+    free(work);
+    _dgs_disc_gauss_mp_cache_store(self, "alias", prec, self->alias, sizeof(dgs_disc_gauss_alias_t)*range);
+
+    for(long x=0; x<range; x++)
+      mpfr_clear(self->rho[x]);
+    free(self->rho);
+    self->rho = NULL;
+    break;
+  }
+
+  case DGS_DISC_GAUSS_CDT: {
+    _dgs_disc_gauss_mp_init_upper_bound(self->upper_bound,
+                                        self->upper_bound_minus_one,
+                                        self->two_upper_bound_minus_one,
+                                        self->sigma, self->tau);
+    _dgs_disc_gauss_mp_init_f(self->f, sigma);
+
+    if (mpz_cmp_ui(self->two_upper_bound_minus_one, ULONG_MAX/sizeof(mpfr_t)) > 0){
+      dgs_disc_gauss_mp_clear(self);
+      dgs_die("integer overflow");
+    }
+
+    long m;
+    if (mpfr_zero_p(self->c_r)) { /* c is an integer, tabulate 0,...,upper_bound-1 and draw a sign */
+      self->call = dgs_disc_gauss_mp_call_cdt;
+      self->B = dgs_bern_uniform_init(0);
+      m = mpz_get_ui(self->upper_bound);
+    } else {
+      self->call = dgs_disc_gauss_mp_call_cdt_offset;
+      m = mpz_get_ui(self->two_upper_bound_minus_one);
+    }
+    self->cdt_limbs = (prec + GMP_NUMB_BITS - 1)/GMP_NUMB_BITS;
+    self->cdt_size = m - 1;
+    self->cdt_tmp = (mp_limb_t*)calloc(2*self->cdt_limbs, sizeof(mp_limb_t));
+    if (!self->cdt_tmp){
       dgs_disc_gauss_mp_clear(self);
       dgs_die("out of memory");
     }
-    
-    //~ // simple robin hood strategy approximates good alias
-    //~ // this precomputation takes ~n^2, but could be reduced by 
-    //~ // using better data structures to compute min and max 
-    //~ // (instead of just linear search each time)
-    mpfr_set_d(self->y, (double)range, MPFR_RNDN);
-    mpfr_div(self->y, self->z, self->y, MPFR_RNDD); // self->y = avg
-    
-    long low = _dgs_disc_gauss_mp_min_in_rho(self, range);
-    long high;
-    mpfr_sub(self->z, self->y, self->rho[low], MPFR_RNDD); // z = avg - rho[low]
-    
-    mpfr_t p;
-    mpfr_init2(p, prec);
-    while(mpfr_cmp_d(self->z,0) > 0) {
-      high = _dgs_disc_gauss_mp_max_in_rho(self, range);
-      mpfr_mul_z(p, self->rho[low], self->two_upper_bound_minus_one, MPFR_RNDN);
-      
-      self->bias[low] = dgs_bern_mp_init(p);
-      mpz_init(self->alias[low]);
-      mpz_set_ui(self->alias[low], high);
-      mpfr_sub(self->rho[high], self->rho[high], self->z, MPFR_RNDU);
-      mpfr_set(self->rho[low], self->y, MPFR_RNDU);
-      
-      low = _dgs_disc_gauss_mp_min_in_rho(self, range);
-      mpfr_sub(self->z, self->y, self->rho[low], MPFR_RNDD); // z = avg - rho[low]
-    }
-    
-    mpfr_clear(p);
+    self->cdt = (mp_limb_t*)_dgs_disc_gauss_mp_cache_load(self, "cdt", prec, sizeof(mp_limb_t)*self->cdt_size*self->cdt_limbs);
+    if (self->cdt)
+      break;
+
+    if (mpfr_zero_p(self->c_r)) {
+      _dgs_disc_gauss_mp_init_rho_range(self, 0, m, prec);
+      mpfr_div_ui(self->rho[0], self->rho[0], 2, MPFR_RNDN);
+    } else {
+      _dgs_disc_gauss_mp_init_rho(self, prec);
+    }
+    _dgs_disc_gauss_mp_init_cdt(self, m, prec);
+    break;
+  }
+
+  case DGS_DISC_GAUSS_KNUTH_YAO: {
+    _dgs_disc_gauss_mp_init_upper_bound(self->upper_bound,
+                                        self->upper_bound_minus_one,
+                                        self->two_upper_bound_minus_one,
+                                        self->sigma, self->tau);
+    _dgs_disc_gauss_mp_init_f(self->f, sigma);
+    self->B = dgs_bern_uniform_init(0);
+
+    if (mpz_cmp_ui(self->two_upper_bound_minus_one, ULONG_MAX/sizeof(mpfr_t)) > 0){
+      dgs_disc_gauss_mp_clear(self);
+      dgs_die("integer overflow");
+    }
+
+    long m;
+    if (mpfr_zero_p(self->c_r)) { /* c is an integer, tabulate 0,...,upper_bound-1 and draw a sign */
+      self->call = dgs_disc_gauss_mp_call_knuth_yao;
+      m = mpz_get_ui(self->upper_bound);
+    } else {
+      self->call = dgs_disc_gauss_mp_call_knuth_yao_offset;
+      m = mpz_get_ui(self->two_upper_bound_minus_one);
+    }
+    self->ky_cols = prec;
+    self->ky_words = (m + 63)/64;
+    self->ky_weight = (long*)_dgs_disc_gauss_mp_cache_load(self, "ky", prec, _dgs_disc_gauss_mp_ky_size(self));
+    if (self->ky_weight) {
+      self->ky = (uint64_t*)(self->ky_weight + self->ky_cols);
+      break;
+    }
+
+    if (mpfr_zero_p(self->c_r)) {
+      _dgs_disc_gauss_mp_init_rho_range(self, 0, m, prec);
+      mpfr_div_ui(self->rho[0], self->rho[0], 2, MPFR_RNDN);
+    } else {
+      _dgs_disc_gauss_mp_init_rho(self, prec);
+    }
+    _dgs_disc_gauss_mp_init_ky(self, m, prec);
     break;
   }
 
@@ -460,18 +727,117 @@ void dgs_disc_gauss_mp_call_uniform_table(mpz_t rop, dgs_disc_gauss_mp_t *self,
   mpz_add(rop, rop, self->c_z);
 }
 
+void dgs_disc_gauss_mp_call_uniform_table_u128(mpz_t rop, dgs_disc_gauss_mp_t *self, gmp_randstate_t state) {
+  const unsigned long n = mpz_get_ui(self->upper_bound);
+  unsigned long x;
+  do {
+    x = gmp_urandomm_ui(state, n);
+  } while (!dgs_bern_u128_call(self->rho_u128[x], state));
+
+  mpz_set_ui(rop, x);
+  if(dgs_bern_uniform_call(self->B, state))
+    mpz_neg(rop, rop);
+  mpz_add(rop, rop, self->c_z);
+}
+
+void dgs_disc_gauss_mp_call_uniform_table_offset_u128(mpz_t rop, dgs_disc_gauss_mp_t *self, gmp_randstate_t state) {
+  const unsigned long n = mpz_get_ui(self->two_upper_bound_minus_one);
+  unsigned long x;
+  do {
+    x = gmp_urandomm_ui(state, n);
+  } while (!dgs_bern_u128_call(self->rho_u128[x], state));
+
+  mpz_set_si(rop, (long)x - (long)mpz_get_ui(self->upper_bound_minus_one));
+  mpz_add(rop, rop, self->c_z);
+}
+
 void dgs_disc_gauss_mp_call_alias(mpz_t rop, dgs_disc_gauss_mp_t *self, gmp_randstate_t state) {
-  mpz_urandomm(rop, state, self->two_upper_bound_minus_one);
-  unsigned long x = mpz_get_ui(rop);
-  if (self->bias[x]) {
-    if (!dgs_bern_mp_call(self->bias[x], state)) {
-      if (!self->alias[x]) {
-        free(self);
-        dgs_die("bias initialized but no alias!");
+  uint64_t u = gmp_urandomb_ui(state, 64);
+  const dgs_disc_gauss_alias_t *a = self->alias + (u >> (64 - self->alias_bits));
+  long x = ((u << self->alias_bits) < a->threshold) ? (long)(a - self->alias) : (long)a->alias;
+  mpz_set_si(rop, x);
+  mpz_sub(rop, rop, self->upper_bound_minus_one);
+  mpz_add(rop, rop, self->c_z);
+}
+
+/* number of entries of self->cdt which are <= a fresh uniform entry */
+static inline unsigned long _dgs_disc_gauss_mp_cdt_scan(dgs_disc_gauss_mp_t *self, gmp_randstate_t state) {
+  const mp_size_t limbs = self->cdt_limbs;
+  mp_limb_t *r = self->cdt_tmp;
+  mp_limb_t *d = self->cdt_tmp + limbs;
+  unsigned long x = 0;
+
+  /* entries of up to 128 bits are compared as integers */
+  if (GMP_NUMB_BITS == 64 && limbs == 1) {
+    const uint64_t u = gmp_urandomb_ui(state, 64);
+    for(long i=0; i<self->cdt_size; i++)
+      x += (u >= self->cdt[i]);
+    return x;
+  }
+  if (GMP_NUMB_BITS == 64 && limbs == 2) {
+    const dgs_u128_t u = (dgs_u128_t)gmp_urandomb_ui(state, 64) << 64 | gmp_urandomb_ui(state, 64);
+    for(long i=0; i<self->cdt_size; i++)
+      x += (u >= ((dgs_u128_t)self->cdt[2*i+1] << 64 | self->cdt[2*i]));
+    return x;
+  }
+
+  mpz_urandomb(self->x, state, limbs*GMP_NUMB_BITS);
+  for(mp_size_t j=0; j<limbs; j++)
+    r[j] = mpz_getlimbn(self->x, j);
+
+  for(long i=0; i<self->cdt_size; i++)
+    x += 1 - mpn_sub_n(d, r, self->cdt + i*limbs, limbs); // no borrow iff r >= cdt[i]
+  return x;
+}
+
+void dgs_disc_gauss_mp_call_cdt(mpz_t rop, dgs_disc_gauss_mp_t *self, gmp_randstate_t state) {
+  mpz_set_ui(rop, _dgs_disc_gauss_mp_cdt_scan(self, state));
+  if(dgs_bern_uniform_call(self->B, state))
+    mpz_neg(rop, rop);
+  mpz_add(rop, rop, self->c_z);
+}
+
+void dgs_disc_gauss_mp_call_cdt_offset(mpz_t rop, dgs_disc_gauss_mp_t *self, gmp_randstate_t state) {
+  mpz_set_ui(rop, _dgs_disc_gauss_mp_cdt_scan(self, state));
+  mpz_sub(rop, rop, self->upper_bound_minus_one);
+  mpz_add(rop, rop, self->c_z);
+}
+
+/* walk the DDG tree: at depth j there are ky_weight[j] leaves, d indexes the node we are at */
+static inline unsigned long _dgs_disc_gauss_mp_ky_walk(dgs_disc_gauss_mp_t *self, gmp_randstate_t state) {
+  while (1) {
+    uint64_t d = 0;
+    for(long j=0; j<self->ky_cols; j++) {
+      d = 2*d + dgs_bern_uniform_call(self->B, state);
+      if (d < (uint64_t)self->ky_weight[j]) {
+        /* the d-th one of column j is our leaf */
+        const uint64_t *col = self->ky + j*self->ky_words;
+        long w = 0;
+        uint64_t c;
+        while (d >= (c = __builtin_popcountll(col[w]))) {
+          d -= c;
+          w++;
+        }
+        uint64_t word = col[w];
+        for(; d>0; d--)
+          word &= word - 1;
+        return 64*w + __builtin_ctzll(word);
       }
-      mpz_set(rop, self->alias[x]);
+      d -= self->ky_weight[j];
     }
+    /* the truncated probabilities sum to less than one, start over */
   }
+}
+
+void dgs_disc_gauss_mp_call_knuth_yao(mpz_t rop, dgs_disc_gauss_mp_t *self, gmp_randstate_t state) {
+  mpz_set_ui(rop, _dgs_disc_gauss_mp_ky_walk(self, state));
+  if(dgs_bern_uniform_call(self->B, state))
+    mpz_neg(rop, rop);
+  mpz_add(rop, rop, self->c_z);
+}
+
+void dgs_disc_gauss_mp_call_knuth_yao_offset(mpz_t rop, dgs_disc_gauss_mp_t *self, gmp_randstate_t state) {
+  mpz_set_ui(rop, _dgs_disc_gauss_mp_ky_walk(self, state));
   mpz_sub(rop, rop, self->upper_bound_minus_one);
   mpz_add(rop, rop, self->c_z);
 }
@@ -527,6 +893,25 @@ void dgs_disc_gauss_mp_call_sigma2_logtable(mpz_t rop, dgs_disc_gauss_mp_t *self
   mpz_add(rop, rop, self->c_z);
 }
 
+/** GENERAL SIGMA :: BULK **/
+
+#define _DGS_DISC_GAUSS_MP_CALL_N(name, T)                                      \
+void name(dgs_disc_gauss_mp_t *self, T *out, size_t n, gmp_randstate_t state) { \
+  void (*call)(mpz_t, dgs_disc_gauss_mp_t *, gmp_randstate_t) = self->call;     \
+  mpz_t rop;                                                                    \
+  mpz_init(rop);                                                                \
+  for(size_t i=0; i<n; i++) {                                                   \
+    call(rop, self, state);                                                     \
+    assert(mpz_fits_slong_p(rop));                                              \
+    out[i] = (T)mpz_get_si(rop);                                                \
+  }                                                                             \
+  mpz_clear(rop);                                                               \
+}
+
+_DGS_DISC_GAUSS_MP_CALL_N(dgs_disc_gauss_mp_call_n, long)
+_DGS_DISC_GAUSS_MP_CALL_N(dgs_disc_gauss_mp_call_n_int32, int32_t)
+_DGS_DISC_GAUSS_MP_CALL_N(dgs_disc_gauss_mp_call_n_int16, int16_t)
+
 /** GENERAL SIGMA :: CLEAR **/
 
 void dgs_disc_gauss_mp_clear(dgs_disc_gauss_mp_t *self) {
@@ -554,22 +939,14 @@ void dgs_disc_gauss_mp_clear(dgs_disc_gauss_mp_t *self) {
     free(self->rho);
   }
   
-  if (self->alias) {
-    for(unsigned long x=0; x<mpz_get_ui(self->two_upper_bound_minus_one); x++) {
-      if (self->alias[x])
-        mpz_clear(self->alias[x]);
-    }
-    free(self->alias);
-  }
-  
-  if (self->bias) {
-    for(unsigned long x=0; x<mpz_get_ui(self->two_upper_bound_minus_one); x++) {
-      if (self->bias[x])
-        dgs_bern_mp_clear(self->bias[x]);
-    }
-    free(self->bias);
-  }
-  
+  if (self->rho_u128 && !dgs_cache_contains(&self->cache, self->rho_u128)) free(self->rho_u128);
+  if (self->alias && !dgs_cache_contains(&self->cache, self->alias)) free(self->alias);
+
+  if (self->cdt && !dgs_cache_contains(&self->cache, self->cdt)) free(self->cdt);
+  if (self->cdt_tmp) free(self->cdt_tmp);
+  if (self->ky_weight && !dgs_cache_contains(&self->cache, self->ky_weight)) free(self->ky_weight); // ky lives in the same block
+  dgs_cache_clear(&self->cache);
+
   if (self->upper_bound)
     mpz_clear(self->upper_bound);
   if (self->upper_bound_minus_one)
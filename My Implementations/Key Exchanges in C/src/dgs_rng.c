@@ -0,0 +1,202 @@
+/**
+   Per-sampler pseudorandom number generators.
+ */
+
+/******************************************************************************
+*
+*                      DGS - Discrete Gaussian Samplers
+*
+* Copyright (c) 2014, Martin Albrecht  <martinralbrecht+dgs@googlemail.com>
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice, this
+*    list of conditions and the following disclaimer.
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+*    this list of conditions and the following disclaimer in the documentation
+*    and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*
+* The views and conclusions contained in the software and documentation are
+* those of the authors and should not be interpreted as representing official
+* policies, either expressed or implied, of the FreeBSD Project.
+******************************************************************************/
+
+#define _DEFAULT_SOURCE // random(), srandom()
+
+#include "dgs_rng.h"
+#include "dgs_misc.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * xoshiro256**
+ */
+
+static inline uint64_t _dgs_rng_rotl(uint64_t x, int k) {
+  return (x << k) | (x >> (64 - k));
+}
+
+static void _dgs_rng_refill_xoshiro256ss(dgs_rng_t *self) {
+  uint64_t *s = self->state.xoshiro;
+  for(size_t i=0; i<DGS_RNG_BUFFER_WORDS; i++) {
+    self->buf[i] = _dgs_rng_rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = _dgs_rng_rotl(s[3], 45);
+  }
+}
+
+/*
+ * ChaCha20 block function (RFC 7539) with a zero nonce and a 64-bit block counter
+ */
+
+#define _DGS_CHACHA_QR(a, b, c, d)                     \
+  a += b; d ^= a; d = (d << 16) | (d >> 16);           \
+  c += d; b ^= c; b = (b << 12) | (b >> 20);           \
+  a += b; d ^= a; d = (d <<  8) | (d >> 24);           \
+  c += d; b ^= c; b = (b <<  7) | (b >> 25)
+
+static void _dgs_rng_chacha20_block(uint32_t out[16], const uint32_t key[8], uint64_t counter) {
+  uint32_t x[16], in[16];
+  in[0] = 0x61707865; in[1] = 0x3320646e; in[2] = 0x79622d32; in[3] = 0x6b206574;
+  memcpy(in + 4, key, 8*sizeof(uint32_t));
+  in[12] = (uint32_t)counter;
+  in[13] = (uint32_t)(counter >> 32);
+  in[14] = 0;
+  in[15] = 0;
+  memcpy(x, in, sizeof(x));
+  for(int i=0; i<10; i++) {
+    _DGS_CHACHA_QR(x[0], x[4], x[ 8], x[12]);
+    _DGS_CHACHA_QR(x[1], x[5], x[ 9], x[13]);
+    _DGS_CHACHA_QR(x[2], x[6], x[10], x[14]);
+    _DGS_CHACHA_QR(x[3], x[7], x[11], x[15]);
+    _DGS_CHACHA_QR(x[0], x[5], x[10], x[15]);
+    _DGS_CHACHA_QR(x[1], x[6], x[11], x[12]);
+    _DGS_CHACHA_QR(x[2], x[7], x[ 8], x[13]);
+    _DGS_CHACHA_QR(x[3], x[4], x[ 9], x[14]);
+  }
+  for(int i=0; i<16; i++)
+    out[i] = x[i] + in[i];
+}
+
+static void _dgs_rng_refill_chacha20(dgs_rng_t *self) {
+  uint32_t block[16];
+  for(size_t i=0; i<DGS_RNG_BUFFER_WORDS; i+=8) {
+    _dgs_rng_chacha20_block(block, self->state.chacha.key, self->state.chacha.counter++);
+    for(size_t j=0; j<8; j++)
+      self->buf[i+j] = ((uint64_t)block[2*j+1] << 32) | block[2*j];
+  }
+}
+
+/*
+ * libc random(), 31 bits per call
+ */
+
+static void _dgs_rng_refill_libc(dgs_rng_t *self) {
+  for(size_t i=0; i<DGS_RNG_BUFFER_WORDS; i++) {
+    self->buf[i] = ((uint64_t)random() << 62) ^ ((uint64_t)random() << 31) ^ (uint64_t)random();
+  }
+}
+
+/*
+ * Seeding
+ */
+
+static uint64_t _dgs_rng_splitmix64(uint64_t *x) {
+  uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+dgs_rng_t *dgs_rng_init(dgs_rng_alg_t algorithm, const uint8_t *seed, size_t seedlen) {
+  uint8_t key[DGS_RNG_SEED_BYTES];
+
+  dgs_rng_t *self = (dgs_rng_t*)calloc(sizeof(dgs_rng_t),1);
+  if (!self) dgs_die("out of memory");
+
+  /* fold the seed into 32 bytes, or read them from the system */
+  if (seed) {
+    memset(key, 0, sizeof(key));
+    for(size_t i=0; i<seedlen; i++)
+      key[i%DGS_RNG_SEED_BYTES] ^= seed[i];
+  } else {
+    FILE *urandom = fopen("/dev/urandom", "rb");
+    if (!urandom || fread(key, 1, sizeof(key), urandom) != sizeof(key)) {
+      uint64_t x = (uint64_t)time(NULL) ^ (uint64_t)(uintptr_t)self;
+      for(size_t i=0; i<sizeof(key); i+=8) {
+        uint64_t r = _dgs_rng_splitmix64(&x);
+        memcpy(key + i, &r, 8);
+      }
+    }
+    if (urandom)
+      fclose(urandom);
+  }
+
+  if (algorithm == DGS_RNG_DEFAULT)
+    algorithm = DGS_RNG_XOSHIRO256SS;
+  self->algorithm = algorithm;
+
+  switch(algorithm) {
+  case DGS_RNG_XOSHIRO256SS: {
+    self->refill = _dgs_rng_refill_xoshiro256ss;
+    /* expand through splitmix64 so that no seed yields the all zero state */
+    uint64_t x = 0;
+    for(size_t i=0; i<4; i++) {
+      uint64_t k;
+      memcpy(&k, key + 8*i, 8);
+      x ^= k;
+      self->state.xoshiro[i] = _dgs_rng_splitmix64(&x);
+    }
+    break;
+  }
+  case DGS_RNG_CHACHA20:
+    self->refill = _dgs_rng_refill_chacha20;
+    for(size_t i=0; i<8; i++)
+      self->state.chacha.key[i] = (uint32_t)key[4*i] | (uint32_t)key[4*i+1] << 8 |
+        (uint32_t)key[4*i+2] << 16 | (uint32_t)key[4*i+3] << 24;
+    self->state.chacha.counter = 0;
+    break;
+  case DGS_RNG_LIBC:
+    self->refill = _dgs_rng_refill_libc;
+    if (seed) {
+      unsigned int s = 0;
+      memcpy(&s, key, sizeof(s));
+      srandom(s);
+    }
+    break;
+  default:
+    free(self);
+    dgs_die("unknown rng algorithm %d", algorithm);
+  }
+
+  memset(key, 0, sizeof(key));
+  self->pos = DGS_RNG_BUFFER_WORDS;
+  return self;
+}
+
+void dgs_rng_clear(dgs_rng_t *self) {
+  if (!self)
+    return;
+  memset(self, 0, sizeof(dgs_rng_t));
+  free(self);
+}
@@ -33,6 +33,7 @@
 #include "dgs.h"
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
 
@@ -42,13 +43,13 @@ static inline long _dgs_rround_dp_unit_gauss(dgs_rround_dp_t *self) {
   do {
     reject = 0;
     x = 0;
-    while (dgs_bern_dp_call(self->B_half_exp))
+    while (dgs_bern_dp_call(self->B_half_exp, self->rng))
       ++x;
     if (x < 2)
       return x;
     
     for(int i = 0; i < x*(x-1); ++i) {
-      if (dgs_bern_dp_call(self->B_half_exp) == 0) {
+      if (dgs_bern_dp_call(self->B_half_exp, self->rng) == 0) {
         reject = 1;
         break;
       }
@@ -58,6 +59,106 @@ static inline long _dgs_rround_dp_unit_gauss(dgs_rround_dp_t *self) {
   return x;
 }
 
+/*
+ * Exact Bernoulli trials for DGS_RROUND_KARNEY_EXACT
+ */
+
+/* a uniform deviate in [0,1), drawn 64 bits at a time when needed */
+typedef struct {
+  uint64_t w[DGS_RROUND_KARNEY_WORDS];
+  int n;
+} _dgs_rround_dp_deviate_t;
+
+static inline uint64_t _dgs_rround_dp_deviate_word(dgs_rround_dp_t *self, _dgs_rround_dp_deviate_t *u, int i) {
+  if (__DGS_UNLIKELY(i >= DGS_RROUND_KARNEY_WORDS))
+    return dgs_rng_uniform_u64(self->rng);
+  while (u->n <= i)
+    u->w[u->n++] = dgs_rng_uniform_u64(self->rng);
+  return u->w[i];
+}
+
+/* u < v */
+static inline int _dgs_rround_dp_deviate_lt(dgs_rround_dp_t *self, _dgs_rround_dp_deviate_t *u, _dgs_rround_dp_deviate_t *v) {
+  for(int i=0; ; i++) {
+    const uint64_t a = _dgs_rround_dp_deviate_word(self, u, i);
+    const uint64_t b = _dgs_rround_dp_deviate_word(self, v, i);
+    if (a != b)
+      return a < b;
+  }
+}
+
+/* u < x, comparing against the binary expansion of x, which is finite */
+static inline int _dgs_rround_dp_deviate_lt_double(dgs_rround_dp_t *self, _dgs_rround_dp_deviate_t *u, double x) {
+  if (x >= 1.0)
+    return 1;
+  for(int i=0; x > 0; i++) {
+    x *= 18446744073709551616.0; // 2^64, so the integer part is the next word
+    const uint64_t b = (uint64_t)x;
+    x -= (double)b;
+    const uint64_t a = _dgs_rround_dp_deviate_word(self, u, i);
+    if (a != b)
+      return a < b;
+  }
+  return 0;
+}
+
+/* Return 1 with probability exp(-x·r) for 0 <= x < 1: count the length n of
+   a run x > u_1 > u_2 > ... where each step also survives with probability r,
+   and return 1 if n is even. If m = 2k+2 > 0 then r = (2k+x)/(2k+2), realised
+   exactly by picking one of m slots, 2k of which survive and one of which
+   survives with probability x. If m = 0 then r = 1. */
+static int _dgs_rround_dp_bern_exp(dgs_rround_dp_t *self, double x, unsigned long m) {
+  _dgs_rround_dp_deviate_t d[2], w;
+  _dgs_rround_dp_deviate_t *y = &d[0], *z = &d[1], *t;
+  unsigned long n = 0;
+  while (1) {
+    z->n = 0;
+    if (!(n == 0 ? _dgs_rround_dp_deviate_lt_double(self, z, x) : _dgs_rround_dp_deviate_lt(self, z, y)))
+      break;
+    if (m) {
+      const unsigned long slot = dgs_rng_uniform(self->rng, m);
+      if (slot == m - 1)
+        break;
+      if (slot == m - 2) {
+        w.n = 0;
+        if (!_dgs_rround_dp_deviate_lt_double(self, &w, x))
+          break;
+      }
+    }
+    t = y; y = z; z = t;
+    n++;
+  }
+  return !(n & 1);
+}
+
+/* as _dgs_rround_dp_unit_gauss() with B_half_exp replaced by exact trials */
+static inline long _dgs_rround_dp_unit_gauss_exact(dgs_rround_dp_t *self) {
+  long x;
+  int reject;
+  do {
+    reject = 0;
+    x = 0;
+    while (_dgs_rround_dp_bern_exp(self, 0.5, 0))
+      ++x;
+    if (x < 2)
+      return x;
+
+    for(int i = 0; i < x*(x-1); ++i) {
+      if (_dgs_rround_dp_bern_exp(self, 0.5, 0) == 0) {
+        reject = 1;
+        break;
+      }
+    }
+  } while(reject);
+
+  return x;
+}
+
+/* ⌈x⌉ without libm, for |x| < 2^63 */
+static inline long _dgs_rround_dp_ceil(double x) {
+  long i = (long)x;
+  return i + ((double)i < x);
+}
 
 dgs_rround_dp_t *dgs_rround_dp_init(size_t tau, dgs_rround_alg_t algorithm) {
   if (tau == 0)
@@ -67,6 +168,8 @@ dgs_rround_dp_t *dgs_rround_dp_init(size_t tau, dgs_rround_alg_t algorithm) {
   if (!self) dgs_die("out of memory");
 
   self->tau = tau;
+  self->rng = dgs_rng_init(DGS_RNG_DEFAULT, NULL, 0);
+  self->rng_owned = 1;
 
   if (algorithm == DGS_RROUND_DEFAULT) {
     algorithm = DGS_RROUND_KARNEY;
@@ -79,14 +182,32 @@ dgs_rround_dp_t *dgs_rround_dp_init(size_t tau, dgs_rround_alg_t algorithm) {
     self->call = dgs_rround_dp_call_uniform_online;
 
     break;
+  case DGS_RROUND_TABLE_CACHE:
   case DGS_RROUND_KARNEY: {
-    self->call = dgs_rround_dp_call_karney;
+    self->call = (algorithm == DGS_RROUND_KARNEY) ? dgs_rround_dp_call_karney : dgs_rround_dp_call_table_cache;
+    self->cache_budget = DGS_RROUND_CACHE_SIZE;
     
     self->B = dgs_bern_uniform_init(0);
     self->B_half_exp = dgs_bern_dp_init(exp(-.5));
+
+    long double sum = 0, cum = 0;
+    for(int k=0; k<DGS_RROUND_KARNEY_CDT_SIZE; k++)
+      sum += expl(-.5L*k*k);
+    for(int k=0; k<DGS_RROUND_KARNEY_CDT_SIZE-1; k++) {
+      cum += expl(-.5L*k*k);
+      long double v = ldexpl(cum/sum, 64);
+      self->karney_cdt[k] = (v >= ldexpl(1.0, 64)) ? UINT64_MAX : (uint64_t)v;
+    }
     
     break;
   }
+  case DGS_RROUND_KARNEY_EXACT: {
+    self->call = dgs_rround_dp_call_karney_exact;
+
+    self->B = dgs_bern_uniform_init(0);
+
+    break;
+  }
   default:
     dgs_rround_dp_clear(self);
     dgs_die("unknown algorithm %d", algorithm);
@@ -106,9 +227,9 @@ long dgs_rround_dp_call_uniform_online(dgs_rround_dp_t *self, double sigma, doub
   long x;
   double y, z;
   do {
-    x = ((long)c) + _dgs_randomm_libc(two_upper_bound_minus_one) - upper_bound_minus_one;
+    x = ((long)c) + dgs_rng_randomm(self->rng, two_upper_bound_minus_one) - upper_bound_minus_one;
     z = exp(((double)x-c)*((double)x-c)*f);
-    y = drand48();
+    y = dgs_rng_uniform_double(self->rng);
   } while (y >= z);
 
   return x;
@@ -119,13 +240,13 @@ long dgs_rround_dp_call_karney(dgs_rround_dp_t *self, double sigma, double c) {
     long k = _dgs_rround_dp_unit_gauss(self);
     
     long s = 1;
-    if (dgs_bern_uniform_call_libc(self->B))
+    if (dgs_bern_uniform_call_rng(self->B, self->rng))
       s *= -1;
     
     double tmp = k*sigma + s*c;
     long i0 = (long)ceil(tmp);
     double x0 = (i0 - tmp)/sigma;
-    long j = _dgs_randomm_libc((unsigned long)ceil(sigma));
+    long j = dgs_rng_randomm(self->rng, (unsigned long)ceil(sigma));
     double x = x0 + ((double)j)/sigma;
     
     if (x >= 1) {
@@ -141,16 +262,204 @@ long dgs_rround_dp_call_karney(dgs_rround_dp_t *self, double sigma, double c) {
     }
     
     double bias = exp(-.5*x*(2*k+x));
-    if (drand48() <= bias) {
+    if (dgs_rng_uniform_double(self->rng) <= bias) {
       return s*(i0 + j);
     }
   } while (1);
 }
 
+long dgs_rround_dp_call_karney_exact(dgs_rround_dp_t *self, double sigma, double c) {
+  if (sigma <= 0.0)
+    dgs_die("sigma must be > 0");
+  const unsigned long sigma_ceil = _dgs_rround_dp_ceil(sigma);
+  do {
+    long k = _dgs_rround_dp_unit_gauss_exact(self);
+
+    long s = 1;
+    if (dgs_bern_uniform_call_rng(self->B, self->rng))
+      s *= -1;
+
+    double tmp = k*sigma + s*c;
+    long i0 = _dgs_rround_dp_ceil(tmp);
+    double x0 = (i0 - tmp)/sigma;
+    long j = dgs_rng_uniform(self->rng, sigma_ceil);
+    double x = x0 + ((double)j)/sigma;
+
+    if (x >= 1) {
+      continue;
+    }
+
+    if (x == 0) {
+      if (k == 0 && s < 0) {
+        continue;
+      } else {
+        return s*(i0 + j);
+      }
+    }
+
+    /* exp(-x(2k+x)/2) = exp(-x(2k+x)/(2k+2))^(k+1) */
+    long i;
+    for(i = 0; i <= k; i++) {
+      if (!_dgs_rround_dp_bern_exp(self, x, 2*k + 2))
+        break;
+    }
+    if (i > k) {
+      return s*(i0 + j);
+    }
+  } while (1);
+}
+
+long dgs_rround_dp_call_table_cache(dgs_rround_dp_t *self, double sigma, double c) {
+  if (sigma <= 0.0)
+    dgs_die("sigma must be > 0");
+  // too wide to tabulate, cf. DGS_DISC_GAUSS_DEFAULT
+  if (2*sigma*self->tau*sizeof(dgs_disc_gauss_alias_t) > DGS_DISC_GAUSS_MAX_TABLE_SIZE_BYTES)
+    return dgs_rround_dp_call_karney(self, sigma, c);
+
+  const double scale = (double)(1UL<<DGS_RROUND_CACHE_QUANTUM_BITS);
+  double c_z = floor(c);
+  double c_r = round((c - c_z)*scale)/scale;
+  if (c_r == 1.0) {
+    c_r = 0.0;
+    c_z += 1.0;
+  }
+  const double s = round(sigma*scale)/scale;
+  if (s == 0.0)
+    return dgs_rround_dp_call_karney(self, sigma, c);
+
+  size_t i;
+  for(i=0; i<self->cache_used; i++) {
+    if (self->cache[i].sigma == s && self->cache[i].c_r == c_r)
+      break;
+  }
+
+  if (++self->cache_calls == DGS_RROUND_CACHE_WINDOW) {
+    // keep rebuilding only as far as the tables paid off
+    self->cache_budget = self->cache_hits/DGS_RROUND_CACHE_HITS_PER_BUILD;
+    if (self->cache_budget == 0)
+      self->cache_budget = 1;
+    self->cache_calls = 0;
+    self->cache_hits = 0;
+  }
+
+  dgs_rround_dp_cache_entry_t e;
+  if (i < self->cache_used) {
+    e = self->cache[i];
+    self->cache_hits++;
+  } else {
+    if (self->cache_budget == 0)
+      return dgs_rround_dp_call_karney(self, sigma, c);
+
+    // a first sighting only goes to seen[], never displacing a table
+    size_t j;
+    for(j=0; j<DGS_RROUND_CACHE_SIZE; j++) {
+      if (self->seen[j].sigma == s && self->seen[j].c_r == c_r)
+        break;
+    }
+    if (j == DGS_RROUND_CACHE_SIZE) {
+      self->seen[self->seen_next].sigma = s;
+      self->seen[self->seen_next].c_r = c_r;
+      self->seen_next = (self->seen_next + 1) % DGS_RROUND_CACHE_SIZE;
+      return dgs_rround_dp_call_karney(self, sigma, c);
+    }
+
+    // seen before, tabulate it in place of the least recently used table
+    self->cache_budget--;
+    self->seen[j].sigma = 0.0;
+    if (self->cache_used == DGS_RROUND_CACHE_SIZE) {
+      i--;
+      dgs_disc_gauss_dp_clear(self->cache[i].D);
+    } else {
+      self->cache_used++;
+    }
+    e.sigma = s;
+    e.c_r = c_r;
+    e.D = dgs_disc_gauss_dp_init_nocache(s, c_r, self->tau, DGS_DISC_GAUSS_ALIAS);
+    dgs_disc_gauss_dp_set_rng(e.D, self->rng);
+  }
+
+  // move to the front
+  memmove(self->cache + 1, self->cache, i*sizeof(dgs_rround_dp_cache_entry_t));
+  self->cache[0] = e;
+
+  return (long)c_z + e.D->call(e.D);
+}
+
+void dgs_rround_dp_call_karney_n(dgs_rround_dp_t *self, double sigma, const double *centers, long *out, size_t n) {
+  assert(self->algorithm == DGS_RROUND_KARNEY);
+  if (sigma <= 0.0)
+    dgs_die("sigma must be > 0");
+
+  const unsigned long sigma_ceil = (unsigned long)ceil(sigma);
+  size_t idx[DGS_DISC_GAUSS_BATCH];
+  long k[DGS_DISC_GAUSS_BATCH], s[DGS_DISC_GAUSS_BATCH], j[DGS_DISC_GAUSS_BATCH], v[DGS_DISC_GAUSS_BATCH];
+  double y[DGS_DISC_GAUSS_BATCH];
+  unsigned char accept[DGS_DISC_GAUSS_BATCH];
+
+  for(size_t first=0; first<n; first+=DGS_DISC_GAUSS_BATCH) {
+    size_t m = (n - first < DGS_DISC_GAUSS_BATCH) ? n - first : DGS_DISC_GAUSS_BATCH;
+    for(size_t t=0; t<m; t++)
+      idx[t] = first + t;
+
+    while (m > 0) {
+      /* candidates: k ~ D_{Z+,1}, a sign, an offset j < ⌈σ⌉ and a uniform y */
+      for(size_t t=0; t<m; t++) {
+        const uint64_t u = dgs_rng_uniform_u64(self->rng);
+        long kt = 0;
+        for(int i=0; i<DGS_RROUND_KARNEY_CDT_SIZE-1; i++)
+          kt += (u >= self->karney_cdt[i]);
+        k[t] = kt;
+      }
+      for(size_t t=0; t<m; t+=64) {
+        const uint64_t bits = dgs_rng_uniform_u64(self->rng);
+        const size_t w = (m - t < 64) ? m - t : 64;
+        for(size_t b=0; b<w; b++)
+          s[t+b] = 1 - 2*(long)((bits >> b) & 1);
+      }
+      for(size_t t=0; t<m; t++) {
+        j[t] = dgs_rng_uniform(self->rng, sigma_ceil);
+        y[t] = dgs_rng_uniform_double(self->rng);
+      }
+
+      /* the acceptance test of dgs_rround_dp_call_karney() */
+      for(size_t t=0; t<m; t++) {
+        const double tmp = k[t]*sigma + s[t]*centers[idx[t]];
+        const double i0 = ceil(tmp);
+        const double x = (i0 - tmp)/sigma + ((double)j[t])/sigma;
+        const double bias = exp(-.5*x*(2*k[t]+x));
+        const int zero_ok = (k[t] != 0) | (s[t] > 0);
+        accept[t] = (x < 1) & ((x == 0) ? zero_ok : (y[t] <= bias));
+        v[t] = s[t]*((long)i0 + j[t]);
+      }
+
+      /* write out accepted samples, keep the rest for the next round */
+      size_t left = 0;
+      for(size_t t=0; t<m; t++) {
+        out[idx[t]] = v[t];
+        idx[left] = idx[t];
+        left += !accept[t];
+      }
+      m = left;
+    }
+  }
+}
+
+void dgs_rround_dp_set_rng(dgs_rround_dp_t *self, dgs_rng_t *rng) {
+  assert(self != NULL && rng != NULL);
+  if (self->rng_owned) dgs_rng_clear(self->rng);
+  self->rng = rng;
+  self->rng_owned = 0;
+  for(size_t i=0; i<self->cache_used; i++)
+    dgs_disc_gauss_dp_set_rng(self->cache[i].D, rng);
+}
+
 void dgs_rround_dp_clear(dgs_rround_dp_t *self) {
   assert(self != NULL);
+  if (self->rng && self->rng_owned) dgs_rng_clear(self->rng);
   if (self->B) dgs_bern_uniform_clear(self->B);
   if (self->B_half_exp) dgs_bern_dp_clear(self->B_half_exp);
+  for(size_t i=0; i<self->cache_used; i++)
+    dgs_disc_gauss_dp_clear(self->cache[i].D);
   
   free(self);
 }
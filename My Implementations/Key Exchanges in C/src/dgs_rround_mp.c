@@ -78,6 +78,98 @@ static inline long _dgs_rround_mp_unit_gauss(dgs_rround_mp_t *self, gmp_randstat
   return x;
 }
 
+/*
+ * Exact Bernoulli trials for DGS_RROUND_KARNEY_EXACT, see dgs_rround_dp.c
+ */
+
+/* a uniform deviate in [0,1), drawn 64 bits at a time when needed */
+typedef struct {
+  uint64_t w[DGS_RROUND_KARNEY_WORDS];
+  int n;
+} _dgs_rround_mp_deviate_t;
+
+static inline uint64_t _dgs_rround_mp_deviate_word(_dgs_rround_mp_deviate_t *u, int i, gmp_randstate_t state) {
+  if (__DGS_UNLIKELY(i >= DGS_RROUND_KARNEY_WORDS))
+    return gmp_urandomb_ui(state, 64);
+  while (u->n <= i)
+    u->w[u->n++] = gmp_urandomb_ui(state, 64);
+  return u->w[i];
+}
+
+/* u < v */
+static inline int _dgs_rround_mp_deviate_lt(_dgs_rround_mp_deviate_t *u, _dgs_rround_mp_deviate_t *v, gmp_randstate_t state) {
+  for(int i=0; ; i++) {
+    const uint64_t a = _dgs_rround_mp_deviate_word(u, i, state);
+    const uint64_t b = _dgs_rround_mp_deviate_word(v, i, state);
+    if (a != b)
+      return a < b;
+  }
+}
+
+/* u < x for 0 <= x < 1, or u < 1/2 if x is NULL, using self->tmp */
+static inline int _dgs_rround_mp_deviate_lt_mpfr(dgs_rround_mp_t *self, _dgs_rround_mp_deviate_t *u, const mpfr_t x, gmp_randstate_t state) {
+  if (!x)
+    return _dgs_rround_mp_deviate_word(u, 0, state) >> 63 == 0;
+  mpfr_set(self->tmp, x, MPFR_RNDN);
+  for(int i=0; !mpfr_zero_p(self->tmp); i++) {
+    mpfr_mul_2ui(self->tmp, self->tmp, 64, MPFR_RNDN); // the integer part is the next word
+    const uint64_t b = mpfr_get_ui(self->tmp, MPFR_RNDZ);
+    mpfr_sub_ui(self->tmp, self->tmp, b, MPFR_RNDN);
+    const uint64_t a = _dgs_rround_mp_deviate_word(u, i, state);
+    if (a != b)
+      return a < b;
+  }
+  return 0;
+}
+
+/* Return 1 with probability exp(-x·r), see _dgs_rround_dp_bern_exp() */
+static int _dgs_rround_mp_bern_exp(dgs_rround_mp_t *self, const mpfr_t x, unsigned long m, gmp_randstate_t state) {
+  _dgs_rround_mp_deviate_t d[2], w;
+  _dgs_rround_mp_deviate_t *y = &d[0], *z = &d[1], *t;
+  unsigned long n = 0;
+  while (1) {
+    z->n = 0;
+    if (!(n == 0 ? _dgs_rround_mp_deviate_lt_mpfr(self, z, x, state) : _dgs_rround_mp_deviate_lt(z, y, state)))
+      break;
+    if (m) {
+      const unsigned long slot = gmp_urandomm_ui(state, m);
+      if (slot == m - 1)
+        break;
+      if (slot == m - 2) {
+        w.n = 0;
+        if (!_dgs_rround_mp_deviate_lt_mpfr(self, &w, x, state))
+          break;
+      }
+    }
+    t = y; y = z; z = t;
+    n++;
+  }
+  return !(n & 1);
+}
+
+/* as _dgs_rround_mp_unit_gauss() with B_half_exp replaced by exact trials */
+static inline long _dgs_rround_mp_unit_gauss_exact(dgs_rround_mp_t *self, gmp_randstate_t state) {
+  long x;
+  int reject;
+  do {
+    reject = 0;
+    x = 0;
+    while (_dgs_rround_mp_bern_exp(self, NULL, 0, state))
+      ++x;
+    if (x < 2)
+      return x;
+
+    for(int i = 0; i < x*(x-1); ++i) {
+      if (_dgs_rround_mp_bern_exp(self, NULL, 0, state) == 0) {
+        reject = 1;
+        break;
+      }
+    }
+  } while(reject);
+
+  return x;
+}
+
 dgs_rround_mp_t *dgs_rround_mp_init(size_t tau, dgs_rround_alg_t algorithm, mpfr_prec_t prec) {
   if (tau == 0)
     dgs_die("tau must be > 0");
@@ -127,6 +219,13 @@ dgs_rround_mp_t *dgs_rround_mp_init(size_t tau, dgs_rround_alg_t algorithm, mpfr
     
     break;
   }
+  case DGS_RROUND_KARNEY_EXACT: {
+    self->call = dgs_rround_mp_call_karney_exact;
+
+    self->B = dgs_bern_uniform_init(0);
+
+    break;
+  }
   default:
     free(self);
     dgs_die("unknown algorithm %d", algorithm);
@@ -167,7 +266,7 @@ void dgs_rround_mp_call_karney(mpz_t rop, dgs_rround_mp_t *self, const mpfr_t si
   do {
     long k = _dgs_rround_mp_unit_gauss(self, state);
     long s = 1;
-    if (dgs_bern_uniform_call_libc(self->B))
+    if (dgs_bern_uniform_call(self->B, state))
       s *= -1;
     
     // double tmp = k*self->sigma + s*self->c; tmp = self->y
@@ -224,6 +323,54 @@ void dgs_rround_mp_call_karney(mpz_t rop, dgs_rround_mp_t *self, const mpfr_t si
   } while (1);
 }
 
+void dgs_rround_mp_call_karney_exact(mpz_t rop, dgs_rround_mp_t *self, const mpfr_t sigma, const mpfr_t c, gmp_randstate_t state) {
+  mpfr_get_z(self->sigma_z, sigma, MPFR_RNDU);
+  do {
+    long k = _dgs_rround_mp_unit_gauss_exact(self, state);
+    long s = 1;
+    if (dgs_bern_uniform_call(self->B, state))
+      s *= -1;
+
+    // i0 = ⌈kσ + sc⌉, x = (i0 - (kσ + sc) + j)/σ as in dgs_rround_mp_call_karney()
+    mpfr_mul_si(self->y, sigma, k, MPFR_RNDN);
+    mpfr_mul_si(self->z, c, s, MPFR_RNDN);
+    mpfr_add(self->y, self->y, self->z, MPFR_RNDN);
+    mpfr_get_z(rop, self->y, MPFR_RNDU);
+    mpfr_z_sub(self->y, rop, self->y, MPFR_RNDN);
+    mpfr_div(self->y, self->y, sigma, MPFR_RNDN);
+    mpz_urandomm(self->x, state, self->sigma_z);
+    mpfr_si_div(self->z, 1, sigma, MPFR_RNDN);
+    mpfr_mul_z(self->z, self->z, self->x, MPFR_RNDN);
+    mpfr_add(self->z, self->z, self->y, MPFR_RNDN);
+
+    if (mpfr_cmp_si(self->z, 1) >= 0) {
+      continue;
+    }
+
+    if (mpfr_zero_p(self->z)) {
+      if (k == 0 && s < 0) {
+        continue;
+      } else {
+        mpz_add(rop, rop, self->x);
+        mpz_mul_si(rop, rop, s);
+        break;
+      }
+    }
+
+    /* exp(-x(2k+x)/2) = exp(-x(2k+x)/(2k+2))^(k+1) */
+    long i;
+    for(i = 0; i <= k; i++) {
+      if (!_dgs_rround_mp_bern_exp(self, self->z, 2*k + 2, state))
+        break;
+    }
+    if (i > k) {
+      mpz_add(rop, rop, self->x);
+      mpz_mul_si(rop, rop, s);
+      break;
+    }
+  } while (1);
+}
+
 void dgs_rround_mp_clear(dgs_rround_mp_t *self) {
   mpz_clear(self->x);
   mpfr_clear(self->y);
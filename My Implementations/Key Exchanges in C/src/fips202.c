@@ -0,0 +1,153 @@
+/********************************************************************************************
+ * A simple provably secure key exchange based on the learning with errors problem
+ *
+ *
+ * Based on the paper:
+ *     Jintai Ding, Xiang Xie and Xiaodong Ling - 2012
+ *
+ * Copyright (c) Jintai Ding, Xiang Xie and Xiaodong Ling for the theoretical key exchange
+ *               Afraz Arif Khan for implementing the key exchange in C and TLS
+ *
+ * Released under the MIT License; see LICENSE.txt for details.
+ ********************************************************************************************/
+
+/** \file fips202.c
+ * SHAKE128 extendable output function (FIPS 202)
+ */
+
+#include <string.h>
+
+#include "fips202.h"
+
+#define KECCAK_ROUNDS 24
+#define ROL(a, offset) (((a) << (offset)) ^ ((a) >> (64 - (offset))))
+
+static const uint64_t keccak_round_constants[KECCAK_ROUNDS] = {
+  0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL,
+  0x8000000080008000ULL, 0x000000000000808bULL, 0x0000000080000001ULL,
+  0x8000000080008081ULL, 0x8000000000008009ULL, 0x000000000000008aULL,
+  0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+  0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL,
+  0x8000000000008003ULL, 0x8000000000008002ULL, 0x8000000000000080ULL,
+  0x000000000000800aULL, 0x800000008000000aULL, 0x8000000080008081ULL,
+  0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL
+};
+
+//Rotation offsets of rho, and the lane visited next by pi, walking lane 1 onwards
+static const unsigned int keccak_rho[24] = {
+   1,  3,  6, 10, 15, 21, 28, 36, 45, 55,  2, 14,
+  27, 41, 56,  8, 25, 43, 62, 18, 39, 61, 20, 44
+};
+
+static const unsigned int keccak_pi[24] = {
+  10,  7, 11, 17, 18,  3,  5, 16,  8, 21, 24,  4,
+  15, 23, 19, 13, 12,  2, 20, 14, 22,  9,  6,  1
+};
+
+static void keccak_f1600(uint64_t s[25]){
+  uint64_t bc[5], t;
+  int round, i, j;
+
+  for(round = 0; round < KECCAK_ROUNDS; round++){
+    //Theta
+    for(i = 0; i < 5; i++){
+      bc[i] = s[i] ^ s[i + 5] ^ s[i + 10] ^ s[i + 15] ^ s[i + 20];
+    }
+    for(i = 0; i < 5; i++){
+      t = bc[(i + 4) % 5] ^ ROL(bc[(i + 1) % 5], 1);
+      for(j = 0; j < 25; j += 5){
+        s[j + i] ^= t;
+      }
+    }
+
+    //Rho and Pi
+    t = s[1];
+    for(i = 0; i < 24; i++){
+      j = keccak_pi[i];
+      bc[0] = s[j];
+      s[j] = ROL(t, keccak_rho[i]);
+      t = bc[0];
+    }
+
+    //Chi
+    for(j = 0; j < 25; j += 5){
+      for(i = 0; i < 5; i++){
+        bc[i] = s[j + i];
+      }
+      for(i = 0; i < 5; i++){
+        s[j + i] ^= (~bc[(i + 1) % 5]) & bc[(i + 2) % 5];
+      }
+    }
+
+    //Iota
+    s[0] ^= keccak_round_constants[round];
+  }
+}
+
+static uint64_t load64(const uint8_t *x){
+  uint64_t r = 0;
+  int i;
+  for(i = 0; i < 8; i++){
+    r |= (uint64_t)x[i] << (8*i);
+  }
+  return r;
+}
+
+static void store64(uint8_t *x, uint64_t u){
+  int i;
+  for(i = 0; i < 8; i++){
+    x[i] = (uint8_t)(u >> (8*i));
+  }
+}
+
+void shake128_absorb(shake128_state *state, const uint8_t *in, size_t inlen){
+  uint8_t block[SHAKE128_RATE];
+  size_t i;
+
+  memset(state->s, 0, sizeof(state->s));
+
+  while(inlen >= SHAKE128_RATE){
+    for(i = 0; i < SHAKE128_RATE/8; i++){
+      state->s[i] ^= load64(in + 8*i);
+    }
+    keccak_f1600(state->s);
+    in += SHAKE128_RATE;
+    inlen -= SHAKE128_RATE;
+  }
+
+  //SHAKE domain separation 1111 followed by pad10*1
+  memset(block, 0, sizeof(block));
+  memcpy(block, in, inlen);
+  block[inlen] = 0x1f;
+  block[SHAKE128_RATE - 1] |= 0x80;
+  for(i = 0; i < SHAKE128_RATE/8; i++){
+    state->s[i] ^= load64(block + 8*i);
+  }
+}
+
+void shake128_squeezeblocks(uint8_t *out, size_t nblocks, shake128_state *state){
+  size_t i;
+  while(nblocks > 0){
+    keccak_f1600(state->s);
+    for(i = 0; i < SHAKE128_RATE/8; i++){
+      store64(out + 8*i, state->s[i]);
+    }
+    out += SHAKE128_RATE;
+    nblocks--;
+  }
+}
+
+void shake128(uint8_t *out, size_t outlen, const uint8_t *in, size_t inlen){
+  shake128_state state;
+  uint8_t block[SHAKE128_RATE];
+  size_t nblocks = outlen/SHAKE128_RATE;
+
+  shake128_absorb(&state, in, inlen);
+  shake128_squeezeblocks(out, nblocks, &state);
+  out += nblocks*SHAKE128_RATE;
+  outlen -= nblocks*SHAKE128_RATE;
+  if(outlen > 0){
+    shake128_squeezeblocks(block, 1, &state);
+    memcpy(out, block, outlen);
+  }
+}
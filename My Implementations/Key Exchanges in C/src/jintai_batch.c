@@ -0,0 +1,123 @@
+/********************************************************************************************
+ * A simple provably secure key exchange based on the learning with errors problem
+ *
+ *
+ * Based on the paper:
+ *     Jintai Ding, Xiang Xie and Xiaodong Ling - 2012
+ *
+ * Copyright (c) Jintai Ding, Xiang Xie and Xiaodong Ling for the theoretical key exchange
+ *               Afraz Arif Khan for implementing the key exchange in C and TLS
+ *
+ * Released under the MIT License; see LICENSE.txt for details.
+ ********************************************************************************************/
+
+/** \file jintai_batch.c
+ * Many independent key exchanges on a pool of pinned worker threads
+ */
+
+#define _GNU_SOURCE // pthread_setaffinity_np, CPU_SET
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "jintai_batch.h"
+
+typedef struct {
+  jintai_ctx_t *ctx;
+  size_t exchanges; // This worker's share of the batch
+  size_t failures;
+  int cpu;          // CPU to pin to, -1 to leave the thread unpinned
+} jintai_worker_t;
+
+static void *jintai_worker(void *arg){
+  jintai_worker_t *worker = (jintai_worker_t*)arg;
+  size_t i;
+
+  if(worker->cpu >= 0){
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(worker->cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set); //Unpinned is still correct, just slower
+  }
+
+  for(i = 0; i < worker->exchanges; i++){
+    if(!jintai_run(worker->ctx)){
+      worker->failures++;
+    }
+  }
+  return NULL;
+}
+
+int jintai_batch_cpus(){
+  cpu_set_t set;
+  if(sched_getaffinity(0, sizeof(set), &set) != 0){
+    return 1;
+  }
+  return CPU_COUNT(&set);
+}
+
+//The n-th CPU of the affinity mask of this process, wrapping around, or -1 if unknown
+static int jintai_batch_cpu(int n){
+  cpu_set_t set;
+  int cpu, seen = 0, total;
+
+  if(sched_getaffinity(0, sizeof(set), &set) != 0 || (total = CPU_COUNT(&set)) == 0){
+    return -1;
+  }
+  n %= total;
+  for(cpu = 0; cpu < CPU_SETSIZE; cpu++){
+    if(CPU_ISSET(cpu, &set) && seen++ == n){
+      return cpu;
+    }
+  }
+  return -1;
+}
+
+jintai_batch_stats_t jintai_run_batch(jintai_ctx_t **ctx_array, size_t count, int threads){
+  jintai_batch_stats_t stats = {0, 0, 0, 0.0, 0.0};
+  jintai_worker_t *workers;
+  pthread_t *tids;
+  struct timespec start, end;
+  int w;
+
+  if(threads < 1){
+    threads = 1;
+  }
+  workers = (jintai_worker_t*)calloc(threads, sizeof(jintai_worker_t));
+  tids = (pthread_t*)malloc(threads*sizeof(pthread_t));
+  if(workers == NULL || tids == NULL){
+    fprintf(stderr, "jintai_run_batch: out of memory\n");
+    abort();
+  }
+
+  for(w = 0; w < threads; w++){
+    workers[w].ctx = ctx_array[w];
+    workers[w].exchanges = count/threads + ((size_t)w < count%threads);
+    workers[w].cpu = jintai_batch_cpu(w);
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(w = 0; w < threads; w++){
+    if(pthread_create(&tids[w], NULL, jintai_worker, &workers[w]) != 0){
+      fprintf(stderr, "jintai_run_batch: cannot start worker %i\n", w);
+      abort();
+    }
+  }
+  for(w = 0; w < threads; w++){
+    pthread_join(tids[w], NULL);
+    stats.exchanges += workers[w].exchanges;
+    stats.failures += workers[w].failures;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  stats.threads = threads;
+  stats.seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec)*1e-9;
+  stats.exchanges_per_second = (stats.seconds > 0) ? stats.exchanges/stats.seconds : 0.0;
+
+  free(tids);
+  free(workers);
+  return stats;
+}
@@ -15,6 +15,8 @@
  * Key exchange between Alice and Bob
  */
 
+#define _POSIX_C_SOURCE 200112L // clock_gettime, rand_r
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
@@ -24,64 +26,56 @@
 
 
 #include "jintailwe.h"
+#include "lwe_matvec.h"
+#include "lwe_gemm.h"
+#include "lwe_modq.h"
+#include "lwe_pack.h"
+#include "jintai_batch.h"
 #include "dgs.h"
 
-int main(int argc, char **argv){
-  D = dgs_disc_gauss_dp_init(LATTICE_DIMENSION,0,6,DGS_DISC_GAUSS_UNIFORM_TABLE);
-  /************ Allocate Temporary Memory on the Fly **************************/
-  uint16_t i, j;
-  //Alice Memory Allocation
-  Alice_params.secret_matrix =      (int**)malloc(LATTICE_DIMENSION*sizeof(int*));
-  for(i = 0; i < LATTICE_DIMENSION; i++){
-    Alice_params.secret_matrix[i] = (int*)malloc(LATTICE_DIMENSION*sizeof(int));
-  }
-  Alice_params.public_matrix =      (int**)malloc(LATTICE_DIMENSION*sizeof(int*));
-  for(i = 0; i < LATTICE_DIMENSION; i++){
-    Alice_params.public_matrix[i] = (int*)malloc(LATTICE_DIMENSION*sizeof(int));
-  }
-
-  EA =                              (int**)malloc(LATTICE_DIMENSION*sizeof(int*));
-  for(i = 0;i < LATTICE_DIMENSION;i++){
-    EA[i] =                         (int*)malloc(LATTICE_DIMENSION*sizeof(int));
-  }
-  edashA =                          (int*)malloc(sizeof(int)*LATTICE_DIMENSION);
+//------TEST RESULTS-----//
+static const int vector_mem = (LATTICE_DIMENSION*sizeof(int));
+static const int matrix_mem = (LATTICE_DIMENSION*LATTICE_DIMENSION*sizeof(int));
+static const int seed_mem = LWE_SEED_BYTES;
 
-  KA =                              (int*)malloc(sizeof(int)*LATTICE_DIMENSION);
+static const int Alice0_mem_vector = 1; //edashA
+static const int Alice0_mem_matrix = 3; //SA, EA, PA
+static const int Bob_mem_vector = 6; //sB, eB, edashB, pB, KB, sigma
+static const int Alice1_mem_vector = 2;
 
-  SKA =                             (int*)malloc(sizeof(int)*LATTICE_DIMENSION);
+static const size_t sampler_bench_samples = 1 << 18; //Samples drawn per sampler by --time-samplers
 
-  //Resampling for Alice:
-  Alice1_params.secret_vector =     (int*)malloc(sizeof(int)*LATTICE_DIMENSION);
-  Alice1_params.public_vector =     (int*)malloc(sizeof(int)*LATTICE_DIMENSION);
+//Wall clock seconds since start
+static double seconds_since(const struct timespec *start){
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec)*1e-9;
+}
 
-  //Bob Memory Allocation
-  Bob_params.secret_vector = (int*)malloc(sizeof(int)*LATTICE_DIMENSION);
-  eB =                       (int*)malloc(sizeof(int)*LATTICE_DIMENSION);
-  Bob_params.public_vector = (int*)malloc(sizeof(int)*LATTICE_DIMENSION);
-  edashB =                   (int*)malloc(sizeof(int)*LATTICE_DIMENSION);
-  KB =                       (int*)malloc(sizeof(int)*LATTICE_DIMENSION);
-  SKB =                      (int*)malloc(sizeof(int)*LATTICE_DIMENSION);
+int main(int argc, char **argv){
+  struct timespec t;
+  lwe_matvec_init();
+  /************ Allocate Temporary Memory on the Fly **************************/
+  //Sampler and one aligned block for everything an exchange needs
+  jintai_ctx_t *ctx = jintai_ctx_init(0);
 
-  //Signal Memory Allocation
-  sig =                      (int*)malloc(sizeof(int)*LATTICE_DIMENSION);
-  time_t t = clock();
+  clock_gettime(CLOCK_MONOTONIC, &t);
   if(argc >= 2){
-    if(strcmp(argv[1],"-help")!=0){
-      run_key_exchange(argc,argv);
+    if(strcmp(argv[1],"-help")!=0 && strcmp(argv[1],"--batch")!=0 && strcmp(argv[1],"--time-samplers")!=0){
+      run_key_exchange(ctx,argc,argv);
     }
   }
   else{
-    run_key_exchange(argc,argv);
+    run_key_exchange(ctx,argc,argv);
   }
-  t = clock() - t;
-  double time_taken = ((double)t)/CLOCKS_PER_SEC;
+  double time_taken = seconds_since(&t);
   if(argc >= 2){
     if(strcmp(argv[1],"--results")==0){
       printf("The total time taken for the key exchange is: %fms\n",time_taken*1000 );
       printf("\n");
       printf("==================Memory Complexity Benchmark=====================\n" );
       printf("\n");
-      memory_consumed();
+      memory_consumed(ctx);
       printf("==============Communicational Complexity Benchmark================\n" );
       printf("\n");
       communication_complexity();
@@ -91,7 +85,13 @@ int main(int argc, char **argv){
       printf("The total time taken for the key exchange is: %fms\n",time_taken*1000 );
     }
     if(strcmp(argv[1],"--mem")==0){
-      memory_consumed();
+      memory_consumed(ctx);
+    }
+    if(strcmp(argv[1],"--batch")==0){
+      batch_throughput(argc, argv);
+    }
+    if(strcmp(argv[1],"--time-samplers")==0){
+      time_samplers();
     }
     if(strcmp(argv[1],"-help")==0){
       printf("COPYRIGHT: Afraz Arif Khan 2018, This software is available under the MIT 2.0 License\n");
@@ -112,6 +112,12 @@ int main(int argc, char **argv){
       printf("\n");
       printf("To view Alice and Bobs Shared Keys:\n");
       printf("./jintailwe --print-keys\n");
+      printf("\n");
+      printf("To run many key exchanges on pinned worker threads (default: 64 exchanges, one thread per CPU):\n");
+      printf("./jintailwe --batch [exchanges] [threads]\n");
+      printf("\n");
+      printf("To view the set up and sampling time of the discrete Gaussian samplers:\n");
+      printf("./jintailwe --time-samplers\n");
     }
   }
 
@@ -120,28 +126,49 @@ int main(int argc, char **argv){
     printf("Type './jintailwe -help' for further instructions\n");
   }
 
+  jintai_ctx_free(ctx);
   return 0;
 }
 
-void run_key_exchange(int argc, char **argv){
-  double time_taken_M;
-  double time_taken_Alice0;
-  double time_taken_Bob;
-  double time_taken_Alice1;
+jintai_ctx_t *jintai_ctx_init(int gemm_threads){
+  jintai_ctx_t *ctx = (jintai_ctx_t*)calloc(1, sizeof(jintai_ctx_t));
+  if(ctx == NULL){
+    fprintf(stderr, "jintai_ctx_init: out of memory\n");
+    abort();
+  }
+  ctx->D = dgs_disc_gauss_dp_init(LATTICE_DIMENSION,0,6,DGS_DISC_GAUSS_UNIFORM_TABLE);
+  ctx->gemm_threads = lwe_gemm_threads(gemm_threads);
+  lwe_arena_init(&ctx->arena, session_bytes(ctx->gemm_threads));
+  ctx->rand_state = (unsigned int)time(NULL) ^ (unsigned int)(uintptr_t)ctx;
+  return ctx;
+}
+
+void jintai_ctx_free(jintai_ctx_t *ctx){
+  if(ctx == NULL){
+    return;
+  }
+  lwe_arena_free(&ctx->arena);
+  dgs_disc_gauss_dp_clear(ctx->D);
+  free(ctx);
+}
+
+bool jintai_run(jintai_ctx_t *ctx){
   double time_taken_temp;
-  srand(time(NULL));
+  struct timespec t, gemm_start;
 
-  time_t t = clock();
-  generate_M();
-  t = clock() - t;
-  time_taken_M = ((double)t)/CLOCKS_PER_SEC;
+  lwe_arena_reset(&ctx->arena);
+  allocate_session(ctx);
 
-  int i, j; // loop index
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  generate_M(ctx);
+  ctx->time_taken_M = seconds_since(&t);
+
+  int i; // loop index
 
   //------- Generate Alices parameters --------
-  t = clock();
-  generate_gaussian_matrix(Alice_params.secret_matrix);
-  generate_gaussian_matrix(EA);
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  generate_gaussian_matrix(ctx, &ctx->Alice_params.secret_matrix);
+  generate_gaussian_matrix(ctx, &ctx->EA);
 
   /*
   Implement the following Algorithm:
@@ -150,54 +177,54 @@ void run_key_exchange(int argc, char **argv){
   */
 
   //Generate Public Parameter
-  for(i = 0; i < LATTICE_DIMENSION; i++){
-    for(j = 0; j < LATTICE_DIMENSION; j++){
-      Alice_params.public_matrix[i][j] = Alice_params.public_matrix[i][j] + (M[i][j]*Alice_params.secret_matrix[i][j] + 2*EA[i][j]);
-      Alice_params.public_matrix[i][j] = (Alice_params.public_matrix[i][j] < 0) ? Alice_params.public_matrix[i][j] % MODULO_Q + MODULO_Q : Alice_params.public_matrix[i][j] % MODULO_Q;
-    }
-  }
+  clock_gettime(CLOCK_MONOTONIC, &gemm_start);
+  lwe_gemm_seeded(ctx->Alice_params.public_matrix.data, ctx->Alice_params.public_matrix.stride, ctx->M_seed,
+                  ctx->Alice_params.secret_matrix.data, ctx->Alice_params.secret_matrix.stride, ctx->EA.data, ctx->EA.stride,
+                  LATTICE_DIMENSION, LATTICE_DIMENSION, LATTICE_DIMENSION, ctx->D->upper_bound, ctx->gemm_threads,
+                  ctx->scratch);
+  ctx->time_taken_gemm = seconds_since(&gemm_start);
+
+  generate_gaussian_vector(ctx, ctx->edashA.data);
+
+  //Send PA to Bob
+  lwe_pack_rows(ctx->A_to_B_wire, ctx->Alice_params.public_matrix.data, ctx->Alice_params.public_matrix.stride,
+                LATTICE_DIMENSION, LATTICE_DIMENSION, LWE_PACK_DROP_BITS);
+  ctx->time_taken_Alice0 = seconds_since(&t);
+  //------- Generate Bobs parameters ----------
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  generate_gaussian_vector(ctx, ctx->Bob_params.secret_vector.data);
+  generate_gaussian_vector(ctx, ctx->eB.data);
+  generate_gaussian_vector(ctx, ctx->edashB.data);
 
+  //Generate Public Parameter: pB = (M^T.sB + 2*eB) mod q
+  lwe_matvec_transposed_seeded(ctx->Bob_params.public_vector.data, ctx->M_seed, LATTICE_DIMENSION, LATTICE_DIMENSION,
+                               ctx->Bob_params.secret_vector.data, ctx->eB.data, ctx->scratch);
 
-  generate_gaussian_vector(edashA);
-  t = clock() - t;
-  time_taken_Alice0 = ((double)t)/CLOCKS_PER_SEC;
-  //------- Generate Bobs parameters ----------
-  t = clock();
-  generate_gaussian_vector(Bob_params.secret_vector);
-  generate_gaussian_vector(eB);
-  generate_gaussian_vector(edashB);
+  //Send pB to Alice
+  lwe_pack(ctx->B_to_A_wire, ctx->Bob_params.public_vector.data, LATTICE_DIMENSION, LWE_PACK_DROP_BITS);
 
-  //Generate Public Parameter
-  for(i = 0; i < LATTICE_DIMENSION;i++){
-    for(j = 0; j < LATTICE_DIMENSION; j++){
-      Bob_params.public_vector[i] = Bob_params.public_vector[i] + (M_TRANSPOSE[i][j]*Bob_params.secret_vector[j] + 2*eB[j]);
-    }
-    Bob_params.public_vector[i] = (Bob_params.public_vector[i] < 0) ? Bob_params.public_vector[i] % MODULO_Q + MODULO_Q : Bob_params.public_vector[i] % MODULO_Q;
-  }
+  //Receive PA, Alice no longer needs her own copy so Bob decodes into it
+  lwe_unpack_rows(ctx->Alice_params.public_matrix.data, ctx->Alice_params.public_matrix.stride, ctx->A_to_B_wire,
+                  LATTICE_DIMENSION, LATTICE_DIMENSION, LWE_PACK_DROP_BITS);
 
-  //Find Bobs Key
+  //Find Bobs Key: KB = (PA^T.sB + 2*e'B) mod q
+  lwe_matvec_transposed(ctx->KB.data, ctx->Alice_params.public_matrix.data, ctx->Alice_params.public_matrix.stride,
+                        LATTICE_DIMENSION, LATTICE_DIMENSION, 0, ctx->Bob_params.secret_vector.data, ctx->edashB.data);
 
-  for(i = 0; i < LATTICE_DIMENSION; i++){
-    for(j = 0; j < LATTICE_DIMENSION; j++){
-      KB[i] = KB[i] + (Alice_params.public_matrix[j][i]*Bob_params.secret_vector[j] + 2*edashB[j])%MODULO_Q;
-    }
-    KB[i] = (KB[i] < 0) ? KB[i] % MODULO_Q + MODULO_Q : KB[i] % MODULO_Q;
-  }
+  ctx->time_taken_Bob = seconds_since(&t);
 
-  t = clock() - t;
-  time_taken_Bob = ((double)t)/CLOCKS_PER_SEC;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  //Receive pB
+  lwe_unpack(ctx->Bob_params.public_vector.data, ctx->B_to_A_wire, LATTICE_DIMENSION, LWE_PACK_DROP_BITS);
 
-  t = clock();
-  //Find Alices Key
-  for(i = 0; i < LATTICE_DIMENSION; i++){
-    for(j = 0; j < LATTICE_DIMENSION; j++){
-      KA[i] = KA[i] + (Alice_params.secret_matrix[j][i]*Bob_params.public_vector[j] + 2*edashA[j])%MODULO_Q;
-    }
-    KA[i] = (KA[i] < 0) ? KA[i] % MODULO_Q + MODULO_Q : KA[i] % MODULO_Q;
-  }
-  t = clock() - t;
-  time_taken_Alice1 = ((double)t)/CLOCKS_PER_SEC;
+  //Find Alices Key: KA = (SA^T.pB + 2*e'A) mod q
+  lwe_matvec_transposed(ctx->KA.data, ctx->Alice_params.secret_matrix.data, ctx->Alice_params.secret_matrix.stride,
+                        LATTICE_DIMENSION, LATTICE_DIMENSION, ctx->D->upper_bound, ctx->Bob_params.public_vector.data,
+                        ctx->edashA.data);
+  ctx->time_taken_Alice1 = seconds_since(&t);
 
+  int *KA = ctx->KA.data;
+  int *KB = ctx->KB.data;
   //-- Check the robust extractor condition till correct params generated ----
   i = 0;
   bool Alice_gen = true;
@@ -207,7 +234,7 @@ void run_key_exchange(int argc, char **argv){
   while(i < LATTICE_DIMENSION){
     if(!check_robust_extractor(KA[i], KB[i])){
       //Redo single parameters
-      long offset = discrete_normal_distribution();
+      long offset = discrete_normal_distribution(ctx);
       if((KA[i] - KB[i])%2 != 0){
         KA[i] = KA[i] - 1; //Make it even
       }
@@ -228,28 +255,33 @@ void run_key_exchange(int argc, char **argv){
     }
   }
 
-  t = clock();
+  clock_gettime(CLOCK_MONOTONIC, &t);
   //Shared Keys
   for(i = 0; i < LATTICE_DIMENSION; i++){
-    sig[i] = signal_function(KB[i], rand()%2);
-    SKA[i] = robust_extractor(KA[i], sig[i]);
-    SKB[i] = robust_extractor(KB[i], sig[i]);
+    ctx->sig.data[i] = signal_function(KB[i], rand_r(&ctx->rand_state)%2);
+    ctx->SKA.data[i] = robust_extractor(KA[i], ctx->sig.data[i]);
+    ctx->SKB.data[i] = robust_extractor(KB[i], ctx->sig.data[i]);
   }
-  t = clock()-t;
-  time_taken_temp = ((double)t)/CLOCKS_PER_SEC;
-  time_taken_Bob = time_taken_Bob + (2/3)*time_taken_temp;
-  time_taken_Alice1 = time_taken_Alice1 + (1/3)*time_taken_temp;
+  time_taken_temp = seconds_since(&t);
+  ctx->time_taken_Bob = ctx->time_taken_Bob + (2/3)*time_taken_temp;
+  ctx->time_taken_Alice1 = ctx->time_taken_Alice1 + (1/3)*time_taken_temp;
 
   /******* RESULTS **********/
 
   bool kex_success = true;
   //--- Check if the keys are the same ---
   for(i = 0;i < LATTICE_DIMENSION; i++){
-    if(SKA[i] != SKB[i]){
+    if(ctx->SKA.data[i] != ctx->SKB.data[i]){
       kex_success = false;
     }
   }
 
+  return kex_success;
+}
+
+void run_key_exchange(jintai_ctx_t *ctx, int argc, char **argv){
+  bool kex_success = jintai_run(ctx);
+
   if(kex_success){
     printf("Key Exchange worked, Alice and Bob Share the same key!\n");
   }
@@ -257,10 +289,10 @@ void run_key_exchange(int argc, char **argv){
   if(argc >= 2){
     if(strcmp(argv[1],"--print-keys")==0){
       printf("Alice's Key is:\n");
-      pretty_print_vector(SKA);
+      pretty_print_vector(ctx->SKA.data);
       printf("\n");
       printf("Bob's key is:\n");
-      pretty_print_vector(SKB);
+      pretty_print_vector(ctx->SKB.data);
       printf("\n");
     }
     if(strcmp(argv[1],"--time-params")==0 || strcmp(argv[1],"--results")==0){
@@ -269,47 +301,97 @@ void run_key_exchange(int argc, char **argv){
       printf(" --------- | -------------\n" );
       printf("|parameter | Time(ms)       \n" );
       printf(" --------  | -------------\n" );
-      printf("| M        | %f\n", time_taken_M*1000);
-      printf("| Alice0   | %f\n", time_taken_Alice0*1000);
-      printf("| Bob      | %f\n", time_taken_Bob*1000);
-      printf("| Alice1   | %f\n", time_taken_Alice1*1000);
+      printf("| M        | %f\n", ctx->time_taken_M*1000);
+      printf("| Alice0   | %f\n", ctx->time_taken_Alice0*1000);
+      printf("| Bob      | %f\n", ctx->time_taken_Bob*1000);
+      printf("| Alice1   | %f\n", ctx->time_taken_Alice1*1000);
       printf(" --------  | -------------\n" );
+      printf("Mat-vec kernel: %s\n", lwe_matvec_kernel_name());
+      printf("Alice0 M.SA product: %f ms, %f GOP/s (2n^3 ops = n^3 multiply-adds mod q)\n", ctx->time_taken_gemm*1000,
+             2.0*LATTICE_DIMENSION*LATTICE_DIMENSION*LATTICE_DIMENSION/ctx->time_taken_gemm*1e-9);
     }
   }
 }
 
-//Generating the public matrix M once and for all
-void generate_M(){
-  int i, j;
+//Scratch of the products, they run one after the other so they share it
+static size_t scratch_bytes(int gemm_threads){
+  size_t gemm = lwe_gemm_scratch_bytes(LATTICE_DIMENSION, gemm_threads);
+  size_t matvec = lwe_matvec_seeded_scratch_bytes(LATTICE_DIMENSION);
+  return (gemm > matvec) ? gemm : matvec;
+}
 
-  for(i = 0; i < LATTICE_DIMENSION; i++){
-    for(j = 0; j < LATTICE_DIMENSION; j++){
-      M[i][j] = rand()%MODULO_Q;
-      M_TRANSPOSE[j][i] = M[i][j];
-    }
-  }
+//Everything one exchange allocates, see allocate_session()
+size_t session_bytes(int gemm_threads){
+  return 3*lwe_matrix_bytes(LATTICE_DIMENSION, LATTICE_DIMENSION)
+       + 12*lwe_vector_bytes(LATTICE_DIMENSION)
+       + lwe_arena_bytes(lwe_pack_rows_bytes(LATTICE_DIMENSION, LATTICE_DIMENSION, LWE_PACK_DROP_BITS))
+       + lwe_arena_bytes(lwe_pack_bytes(LATTICE_DIMENSION, LWE_PACK_DROP_BITS))
+       + lwe_arena_bytes(scratch_bytes(gemm_threads));
 }
 
-//This function is broken for the globals
-void generate_gaussian_matrix(int **gauss_matrix){
+void allocate_session(jintai_ctx_t *ctx){
+  //Alice
+  lwe_matrix_alloc(&ctx->Alice_params.secret_matrix, &ctx->arena, LATTICE_DIMENSION, LATTICE_DIMENSION);
+  lwe_matrix_alloc(&ctx->Alice_params.public_matrix, &ctx->arena, LATTICE_DIMENSION, LATTICE_DIMENSION);
+  lwe_matrix_alloc(&ctx->EA, &ctx->arena, LATTICE_DIMENSION, LATTICE_DIMENSION);
+  lwe_vector_alloc(&ctx->edashA, &ctx->arena, LATTICE_DIMENSION);
+  lwe_vector_alloc(&ctx->KA, &ctx->arena, LATTICE_DIMENSION);
+  lwe_vector_alloc(&ctx->SKA, &ctx->arena, LATTICE_DIMENSION);
+
+  //Resampling for Alice
+  lwe_vector_alloc(&ctx->Alice1_params.secret_vector, &ctx->arena, LATTICE_DIMENSION);
+  lwe_vector_alloc(&ctx->Alice1_params.public_vector, &ctx->arena, LATTICE_DIMENSION);
+
+  //Bob
+  lwe_vector_alloc(&ctx->Bob_params.secret_vector, &ctx->arena, LATTICE_DIMENSION);
+  lwe_vector_alloc(&ctx->eB, &ctx->arena, LATTICE_DIMENSION);
+  lwe_vector_alloc(&ctx->Bob_params.public_vector, &ctx->arena, LATTICE_DIMENSION);
+  lwe_vector_alloc(&ctx->edashB, &ctx->arena, LATTICE_DIMENSION);
+  lwe_vector_alloc(&ctx->KB, &ctx->arena, LATTICE_DIMENSION);
+  lwe_vector_alloc(&ctx->SKB, &ctx->arena, LATTICE_DIMENSION);
+
+  //Signal
+  lwe_vector_alloc(&ctx->sig, &ctx->arena, LATTICE_DIMENSION);
+
+  //Wire
+  ctx->A_to_B_wire = (uint8_t*)lwe_arena_alloc(&ctx->arena,
+                                               lwe_pack_rows_bytes(LATTICE_DIMENSION, LATTICE_DIMENSION, LWE_PACK_DROP_BITS));
+  ctx->B_to_A_wire = (uint8_t*)lwe_arena_alloc(&ctx->arena, lwe_pack_bytes(LATTICE_DIMENSION, LWE_PACK_DROP_BITS));
+
+  //Products
+  ctx->scratch = lwe_arena_alloc(&ctx->arena, scratch_bytes(ctx->gemm_threads));
+}
+
+//Generating the seed of the public matrix M once and for all
+void generate_M(jintai_ctx_t *ctx){
+  FILE *urandom = fopen("/dev/urandom", "rb");
+  int i;
 
-  //#pragma omp parallel for collapse(2)
-  for(int i = 0; i < LATTICE_DIMENSION; i++){
-    for(int j = 0; j < LATTICE_DIMENSION; j++){
-      gauss_matrix[i][j] = discrete_normal_distribution();
+  if(urandom == NULL || fread(ctx->M_seed, 1, LWE_SEED_BYTES, urandom) != LWE_SEED_BYTES){
+    for(i = 0; i < LWE_SEED_BYTES; i++){
+      ctx->M_seed[i] = rand_r(&ctx->rand_state) & 0xff;
     }
   }
+  if(urandom != NULL){
+    fclose(urandom);
+  }
 }
 
-void generate_gaussian_vector(int gauss_vec[LATTICE_DIMENSION]){
-  int i; //Loop index
-  for(i = 0; i < LATTICE_DIMENSION; i++){
-    gauss_vec[i] = discrete_normal_distribution();
+void generate_gaussian_matrix(jintai_ctx_t *ctx, lwe_matrix_t *gauss_matrix){
+  size_t i;
+
+  //One bulk call per row, the stride padding is left alone
+  for(i = 0; i < gauss_matrix->rows; i++){
+    dgs_disc_gauss_dp_call_n_int32(ctx->D, (int32_t *)LWE_MATRIX_ROW(gauss_matrix, i), gauss_matrix->cols);
   }
 }
 
-int generate_gaussian_scalar(){
-  return discrete_normal_distribution();
+void generate_gaussian_vector(jintai_ctx_t *ctx, int gauss_vec[LATTICE_DIMENSION]){
+  dgs_disc_gauss_dp_call_n_int32(ctx->D, (int32_t *)gauss_vec, LATTICE_DIMENSION);
+}
+
+int generate_gaussian_scalar(jintai_ctx_t *ctx){
+  return discrete_normal_distribution(ctx);
 }
 
 int robust_extractor(int x, int sigma){
@@ -325,11 +407,11 @@ int signal_function(int y, int b){
   return !(y >= floor(-MODULO_Q/4) + b && y <= floor(MODULO_Q/4) + b);
 }
 
-void pretty_print_matrix(int **matrix){
-  int i, j;
-  for(i = 0; i < LATTICE_DIMENSION; i++){
-    for(j = 0; j < LATTICE_DIMENSION; j++){
-      printf("Matrix[%i][%i] = %i\n", i, j, matrix[i][j]);
+void pretty_print_matrix(const lwe_matrix_t *matrix){
+  size_t i, j;
+  for(i = 0; i < matrix->rows; i++){
+    for(j = 0; j < matrix->cols; j++){
+      printf("Matrix[%zu][%zu] = %i\n", i, j, LWE_MATRIX_ROW(matrix, i)[j]);
     }
     printf("\n");
   }
@@ -344,28 +426,127 @@ void pretty_print_vector(int vec[LATTICE_DIMENSION]){
 /*------------------- Generate Gaussian numbers in C -------------------------*/
 
 //Makes use of the dgs library
-long discrete_normal_distribution(){
-  long val = D->call(D);
+long discrete_normal_distribution(jintai_ctx_t *ctx){
+  long val = ctx->D->call(ctx->D);
   return val;
 }
 
 /*---------------------------- Test Results ----------------------------------*/
-void memory_consumed(){
+void memory_consumed(const jintai_ctx_t *ctx){
   printf(" --------- | -------------\n" );
   printf("|parameter | bytes        \n" );
   printf(" --------  | -------------\n" );
-  printf("| M        | %i           \n", matrix_mem);
+  printf("| M (seed) | %i           \n", seed_mem);
   printf("| Alice0   | %i           \n", Alice0_mem_vector*vector_mem + Alice0_mem_matrix*matrix_mem);
   printf("| Bob      | %i           \n", Bob_mem_vector*vector_mem);
   printf("| Alice1   | %i           \n", Alice1_mem_vector*vector_mem);
+  printf("| Arena    | %zu           \n", ctx->arena.size);
   printf(" --------- | -------------\n" );
 }
 
-void communication_complexity(){
+//Throughput of jintai_run_batch() on threads workers, against a single worker
+void batch_throughput(int argc, char **argv){
+  size_t count = (argc >= 3) ? strtoul(argv[2], NULL, 10) : 64;
+  int threads = (argc >= 4) ? atoi(argv[3]) : jintai_batch_cpus();
+  jintai_batch_stats_t single, stats;
+  jintai_ctx_t **ctx;
+  int w;
+
+  if(threads < 1){
+    threads = 1;
+  }
+  ctx = (jintai_ctx_t**)malloc(threads*sizeof(jintai_ctx_t*));
+  if(ctx == NULL){
+    fprintf(stderr, "batch_throughput: out of memory\n");
+    abort();
+  }
+  for(w = 0; w < threads; w++){
+    ctx[w] = jintai_ctx_init(1);
+  }
+
+  //Same work per worker in both runs, so the ratio measures scaling alone
+  single = jintai_run_batch(ctx, (count + threads - 1)/threads, 1);
+  stats = jintai_run_batch(ctx, count, threads);
+
   printf(" --------- | -------------\n" );
-  printf("|   Communication(bytes)  \n" );
+  printf("|   Batch Throughput       \n" );
   printf(" --------- | -------------\n" );
-  printf("|  A -> B  | %i           \n", matrix_mem );
-  printf("|  B -> A  | %i           \n", 2*vector_mem );
+  printf("| Threads  | %i\n", stats.threads);
+  printf("| Exchanges| %zu (%zu failed)\n", stats.exchanges, stats.failures + single.failures);
+  printf("| Time     | %f ms\n", stats.seconds*1000);
+  printf("| 1 thread | %f exchanges/s\n", single.exchanges_per_second);
+  printf("| Pool     | %f exchanges/s\n", stats.exchanges_per_second);
+  printf("| Scaling  | %.1f%% per core\n", 100.0*stats.exchanges_per_second/(stats.threads*single.exchanges_per_second));
   printf(" --------- | -------------\n" );
+
+  for(w = 0; w < threads; w++){
+    jintai_ctx_free(ctx[w]);
+  }
+  free(ctx);
+}
+
+void time_samplers(){
+  static const struct { const char *name; dgs_disc_gauss_alg_t algorithm; } samplers[] = {
+    {"Table    ", DGS_DISC_GAUSS_UNIFORM_TABLE},
+    {"Alias    ", DGS_DISC_GAUSS_ALIAS},
+    {"CDT      ", DGS_DISC_GAUSS_CDT},
+    {"KnuthYao ", DGS_DISC_GAUSS_KNUTH_YAO},
+  };
+  struct timespec t;
+  double init, sample;
+  size_t i;
+  int32_t *buf = (int32_t*)malloc(sampler_bench_samples*sizeof(int32_t));
+  if(buf == NULL){
+    fprintf(stderr, "time_samplers: out of memory\n");
+    abort();
+  }
+
+  printf(" --------- | ------------- | -------------\n" );
+  printf("|   Samplers, sigma = %i, tau = 6\n", LATTICE_DIMENSION);
+  printf(" --------- | ------------- | -------------\n" );
+  printf("| Sampler  | Init(ms)      | Sample(ns)\n");
+  for(i = 0; i < sizeof(samplers)/sizeof(samplers[0]); i++){
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    dgs_disc_gauss_dp_t *D = dgs_disc_gauss_dp_init(LATTICE_DIMENSION,0,6,samplers[i].algorithm);
+    init = seconds_since(&t);
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    dgs_disc_gauss_dp_call_n_int32(D, buf, sampler_bench_samples);
+    sample = seconds_since(&t);
+    printf("| %s| %f      | %f\n", samplers[i].name, init*1000, sample*1e9/sampler_bench_samples);
+    dgs_disc_gauss_dp_clear(D);
+  }
+
+  //The MPFR alias table, the only mp sampler with a table of this size
+  mpfr_t sigma, c;
+  gmp_randstate_t state;
+  mpfr_init_set_si(sigma, LATTICE_DIMENSION, MPFR_RNDN);
+  mpfr_init_set_si(c, 0, MPFR_RNDN);
+  gmp_randinit_default(state);
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  dgs_disc_gauss_mp_t *M = dgs_disc_gauss_mp_init(sigma, c, 6, DGS_DISC_GAUSS_ALIAS);
+  init = seconds_since(&t);
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  dgs_disc_gauss_mp_call_n_int32(M, buf, sampler_bench_samples/16, state);
+  sample = seconds_since(&t);
+  printf("| Alias mp | %f      | %f\n", init*1000, sample*1e9/(sampler_bench_samples/16));
+  printf(" --------- | ------------- | -------------\n" );
+  dgs_disc_gauss_mp_clear(M);
+  gmp_randclear(state);
+  mpfr_clear(c);
+  mpfr_clear(sigma);
+  free(buf);
+}
+
+void communication_complexity(){
+  //PA and pB go out packed, the signal is still sent as ints
+  size_t packed_matrix = lwe_pack_rows_bytes(LATTICE_DIMENSION, LATTICE_DIMENSION, LWE_PACK_DROP_BITS);
+  size_t packed_vector = lwe_pack_bytes(LATTICE_DIMENSION, LWE_PACK_DROP_BITS);
+
+  printf(" --------- | ------------- | -------------\n" );
+  printf("|   Communication(bytes)  \n" );
+  printf(" --------- | ------------- | -------------\n" );
+  printf("|          | raw           | packed (%i bits)\n", LWE_PACK_BITS - LWE_PACK_DROP_BITS);
+  printf("|  A -> B  | %i       | %zu\n", matrix_mem + seed_mem, packed_matrix + seed_mem );
+  printf("|  B -> A  | %i          | %zu\n", 2*vector_mem, packed_vector + vector_mem );
+  printf(" --------- | ------------- | -------------\n" );
 }
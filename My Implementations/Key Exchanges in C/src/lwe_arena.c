@@ -0,0 +1,89 @@
+/********************************************************************************************
+ * A simple provably secure key exchange based on the learning with errors problem
+ *
+ *
+ * Based on the paper:
+ *     Jintai Ding, Xiang Xie and Xiaodong Ling - 2012
+ *
+ * Copyright (c) Jintai Ding, Xiang Xie and Xiaodong Ling for the theoretical key exchange
+ *               Afraz Arif Khan for implementing the key exchange in C and TLS
+ *
+ * Released under the MIT License; see LICENSE.txt for details.
+ ********************************************************************************************/
+
+/** \file lwe_arena.c
+ * Aligned matrix and vector types carved out of a per-session arena
+ */
+
+#define _POSIX_C_SOURCE 200112L // posix_memalign
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "lwe_arena.h"
+
+#define LWE_ARENA_ROW_INTS (LWE_ARENA_ALIGN/sizeof(int))
+
+size_t lwe_arena_bytes(size_t bytes){
+  return (bytes + LWE_ARENA_ALIGN - 1) & ~(size_t)(LWE_ARENA_ALIGN - 1);
+}
+
+static size_t lwe_matrix_stride(size_t cols){
+  return (cols + LWE_ARENA_ROW_INTS - 1)/LWE_ARENA_ROW_INTS*LWE_ARENA_ROW_INTS;
+}
+
+size_t lwe_matrix_bytes(size_t rows, size_t cols){
+  return lwe_arena_bytes(rows*lwe_matrix_stride(cols)*sizeof(int));
+}
+
+size_t lwe_vector_bytes(size_t len){
+  return lwe_arena_bytes(len*sizeof(int));
+}
+
+void lwe_arena_init(lwe_arena_t *arena, size_t size){
+  void *base = NULL;
+  size = lwe_arena_bytes(size);
+  if(posix_memalign(&base, LWE_ARENA_ALIGN, (size > 0) ? size : LWE_ARENA_ALIGN) != 0){
+    fprintf(stderr, "lwe_arena_init: out of memory\n");
+    abort();
+  }
+  arena->base = (uint8_t*)base;
+  arena->size = size;
+  arena->used = 0;
+}
+
+void *lwe_arena_alloc(lwe_arena_t *arena, size_t bytes){
+  void *p;
+  bytes = lwe_arena_bytes(bytes);
+  if(bytes > arena->size - arena->used){
+    fprintf(stderr, "lwe_arena_alloc: arena exhausted (%zu of %zu bytes used, %zu requested)\n",
+            arena->used, arena->size, bytes);
+    abort();
+  }
+  p = arena->base + arena->used;
+  arena->used += bytes;
+  return p;
+}
+
+void lwe_arena_reset(lwe_arena_t *arena){
+  arena->used = 0;
+}
+
+void lwe_arena_free(lwe_arena_t *arena){
+  free(arena->base);
+  arena->base = NULL;
+  arena->size = 0;
+  arena->used = 0;
+}
+
+void lwe_matrix_alloc(lwe_matrix_t *m, lwe_arena_t *arena, size_t rows, size_t cols){
+  m->rows = rows;
+  m->cols = cols;
+  m->stride = lwe_matrix_stride(cols);
+  m->data = (int*)lwe_arena_alloc(arena, lwe_matrix_bytes(rows, cols));
+}
+
+void lwe_vector_alloc(lwe_vector_t *v, lwe_arena_t *arena, size_t len){
+  v->len = len;
+  v->data = (int*)lwe_arena_alloc(arena, lwe_vector_bytes(len));
+}
@@ -0,0 +1,68 @@
+/********************************************************************************************
+ * A simple provably secure key exchange based on the learning with errors problem
+ *
+ *
+ * Based on the paper:
+ *     Jintai Ding, Xiang Xie and Xiaodong Ling - 2012
+ *
+ * Copyright (c) Jintai Ding, Xiang Xie and Xiaodong Ling for the theoretical key exchange
+ *               Afraz Arif Khan for implementing the key exchange in C and TLS
+ *
+ * Released under the MIT License; see LICENSE.txt for details.
+ ********************************************************************************************/
+
+/** \file lwe_expand.c
+ * Deterministic expansion of the public matrix M from a short seed
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include "lwe_expand.h"
+#include "fips202.h"
+
+//Smallest 2^k - 1 covering every value below q
+static uint32_t lwe_expand_mask(){
+  uint32_t m = MODULO_Q - 1;
+  m |= m >> 1;
+  m |= m >> 2;
+  m |= m >> 4;
+  m |= m >> 8;
+  m |= m >> 16;
+  return m;
+}
+
+void lwe_expand_rows(int *rows, size_t stride, const uint8_t seed[LWE_SEED_BYTES],
+                     size_t first, size_t nrows, size_t cols){
+  uint8_t in[LWE_SEED_BYTES + 2];
+  uint8_t buf[SHAKE128_RATE];
+  shake128_state state;
+  const uint32_t mask = lwe_expand_mask();
+  size_t r, c, pos;
+
+  assert(first + nrows <= 65536);
+  memcpy(in, seed, LWE_SEED_BYTES);
+
+  for(r = 0; r < nrows; r++){
+    int *row = rows + r*stride;
+    in[LWE_SEED_BYTES]     = (uint8_t)(first + r);
+    in[LWE_SEED_BYTES + 1] = (uint8_t)((first + r) >> 8);
+    shake128_absorb(&state, in, sizeof(in));
+
+    pos = SHAKE128_RATE;
+    c = 0;
+    while(c < cols){
+      uint32_t v;
+      if(pos == SHAKE128_RATE){
+        shake128_squeezeblocks(buf, 1, &state);
+        pos = 0;
+      }
+      v = ((uint32_t)buf[pos] | (uint32_t)buf[pos + 1] << 8 |
+           (uint32_t)buf[pos + 2] << 16 | (uint32_t)buf[pos + 3] << 24) & mask;
+      pos += 4;
+      if(v < MODULO_Q){
+        row[c++] = (int)v;
+      }
+    }
+  }
+}
@@ -0,0 +1,157 @@
+/********************************************************************************************
+ * A simple provably secure key exchange based on the learning with errors problem
+ *
+ *
+ * Based on the paper:
+ *     Jintai Ding, Xiang Xie and Xiaodong Ling - 2012
+ *
+ * Copyright (c) Jintai Ding, Xiang Xie and Xiaodong Ling for the theoretical key exchange
+ *               Afraz Arif Khan for implementing the key exchange in C and TLS
+ *
+ * Released under the MIT License; see LICENSE.txt for details.
+ ********************************************************************************************/
+
+/** \file lwe_gemm.c
+ * Blocked, multithreaded matrix-matrix product modulo q
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "lwe_gemm.h"
+#include "lwe_modq.h"
+#include "lwe_arena.h"
+
+//Bytes of one thread's slice of the scratch: accumulators, packed slab of B and expanded rows of A
+static size_t lwe_gemm_slice_bytes(size_t k){
+  return lwe_arena_bytes(LWE_GEMM_MC*LWE_GEMM_NC*sizeof(int64_t))
+       + lwe_arena_bytes(LWE_GEMM_KC*LWE_GEMM_NC*sizeof(int))
+       + lwe_arena_bytes(LWE_GEMM_MC*k*sizeof(int));
+}
+
+int lwe_gemm_threads(int threads){
+#ifdef _OPENMP
+  return (threads > 0) ? threads : omp_get_max_threads();
+#else
+  (void)threads;
+  return 1;
+#endif
+}
+
+size_t lwe_gemm_scratch_bytes(size_t k, int threads){
+  return (size_t)lwe_gemm_threads(threads)*lwe_gemm_slice_bytes(k);
+}
+
+//A is read from memory, or expanded panel by panel from seed when A is NULL
+static void lwe_gemm_core(int *C, size_t ldc, const int *A, size_t lda, const uint8_t *seed,
+                          const int *B, size_t ldb, const int *E, size_t lde, size_t m, size_t k, size_t n,
+                          unsigned int b_bound, int threads, void *scratch){
+  uint64_t lazy = lwe_modq_lazy_terms((uint64_t)(MODULO_Q - 1)*((b_bound != 0) ? b_bound : MODULO_Q - 1));
+  long panels = (long)((m + LWE_GEMM_MC - 1)/LWE_GEMM_MC);
+  size_t slice = lwe_gemm_slice_bytes(k);
+
+  if(lazy == 0){
+    lazy = 1;
+  }
+
+  #pragma omp parallel num_threads(lwe_gemm_threads(threads))
+  {
+    //Per thread accumulators for one row panel, a packing buffer for one slab of B and the expanded rows of A,
+    //all in this thread's slice of the scratch (OpenMP never hands out more threads than asked for)
+    int tid = 0;
+    uint8_t *mine;
+    int64_t *acc;
+    int *pack, *expanded;
+    long p;
+#ifdef _OPENMP
+    tid = omp_get_thread_num();
+#endif
+    mine = (uint8_t*)scratch + (size_t)tid*slice;
+    acc = (int64_t*)mine;
+    pack = (int*)(mine + lwe_arena_bytes(LWE_GEMM_MC*LWE_GEMM_NC*sizeof(int64_t)));
+    expanded = (int*)((uint8_t*)pack + lwe_arena_bytes(LWE_GEMM_KC*LWE_GEMM_NC*sizeof(int)));
+
+    #pragma omp for schedule(dynamic)
+    for(p = 0; p < panels; p++){
+      size_t i0 = (size_t)p*LWE_GEMM_MC;
+      size_t mc = (m - i0 < LWE_GEMM_MC) ? m - i0 : LWE_GEMM_MC;
+      size_t i, c, r, j0, k0, nc, kc, pending;
+      const int *Ap;
+      size_t ap_stride;
+
+      if(A != NULL){
+        Ap = A + i0*lda;
+        ap_stride = lda;
+      }
+      else{
+        lwe_expand_rows(expanded, k, seed, i0, mc, k);
+        Ap = expanded;
+        ap_stride = k;
+      }
+
+      for(j0 = 0; j0 < n; j0 += LWE_GEMM_NC){
+        nc = (n - j0 < LWE_GEMM_NC) ? n - j0 : LWE_GEMM_NC;
+        for(i = 0; i < mc; i++){
+          for(c = 0; c < nc; c++){
+            acc[i*LWE_GEMM_NC + c] = (E != NULL) ? 2*(int64_t)E[(i0 + i)*lde + j0 + c] : 0;
+          }
+        }
+
+        pending = 0;
+        for(k0 = 0; k0 < k; k0 += kc){
+          const int *slab;
+          size_t stride;
+
+          kc = (k - k0 < LWE_GEMM_KC) ? k - k0 : LWE_GEMM_KC;
+          kc = (kc < lazy) ? kc : lazy;
+          if(pending + kc > lazy){
+            for(i = 0; i < mc*LWE_GEMM_NC; i++){
+              acc[i] = lwe_modq_reduce(acc[i]);
+            }
+            pending = 0;
+          }
+
+          //Full width rows of B are already a contiguous slab
+          if(nc == ldb){
+            slab = B + k0*ldb;
+            stride = ldb;
+          }
+          else{
+            for(r = 0; r < kc; r++){
+              memcpy(pack + r*nc, B + (k0 + r)*ldb + j0, nc*sizeof(int));
+            }
+            slab = pack;
+            stride = nc;
+          }
+
+          for(i = 0; i < mc; i++){
+            lwe_matvec_accumulate(acc + i*LWE_GEMM_NC, slab, stride, kc, nc, Ap + i*ap_stride + k0);
+          }
+          pending += kc;
+        }
+
+        for(i = 0; i < mc; i++){
+          for(c = 0; c < nc; c++){
+            C[(i0 + i)*ldc + j0 + c] = lwe_modq_reduce(acc[i*LWE_GEMM_NC + c]);
+          }
+        }
+      }
+    }
+  }
+}
+
+void lwe_gemm(int *C, size_t ldc, const int *A, size_t lda, const int *B, size_t ldb,
+              const int *E, size_t lde, size_t m, size_t k, size_t n, unsigned int b_bound, int threads, void *scratch){
+  lwe_gemm_core(C, ldc, A, lda, NULL, B, ldb, E, lde, m, k, n, b_bound, threads, scratch);
+}
+
+void lwe_gemm_seeded(int *C, size_t ldc, const uint8_t seed[LWE_SEED_BYTES], const int *B, size_t ldb,
+                     const int *E, size_t lde, size_t m, size_t k, size_t n, unsigned int b_bound, int threads,
+                     void *scratch){
+  lwe_gemm_core(C, ldc, NULL, 0, seed, B, ldb, E, lde, m, k, n, b_bound, threads, scratch);
+}
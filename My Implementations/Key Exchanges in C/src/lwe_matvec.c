@@ -0,0 +1,249 @@
+/********************************************************************************************
+ * A simple provably secure key exchange based on the learning with errors problem
+ *
+ *
+ * Based on the paper:
+ *     Jintai Ding, Xiang Xie and Xiaodong Ling - 2012
+ *
+ * Copyright (c) Jintai Ding, Xiang Xie and Xiaodong Ling for the theoretical key exchange
+ *               Afraz Arif Khan for implementing the key exchange in C and TLS
+ *
+ * Released under the MIT License; see LICENSE.txt for details.
+ ********************************************************************************************/
+
+/** \file lwe_matvec.c
+ * Cache-blocked matrix-vector products modulo q
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "lwe_matvec.h"
+#include "lwe_modq.h"
+#include "lwe_arena.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LWE_MATVEC_X86 1
+#include <immintrin.h>
+#endif
+
+/*
+ A panel kernel adds A[r][c]*x[r] into acc[c] for rn rows and cn columns, where A
+ and x already point at the top left corner of the panel.
+*/
+typedef void (*lwe_panel_kernel_t)(int64_t *acc, const int *A, size_t stride,
+                                   const int *x, size_t rn, size_t cn);
+
+static void lwe_panel_scalar(int64_t *acc, const int *A, size_t stride,
+                             const int *x, size_t rn, size_t cn){
+  size_t r, c;
+  for(r = 0; r < rn; r++){
+    const int *a = A + r*stride;
+    const int64_t xr = x[r];
+    for(c = 0; c < cn; c++){
+      acc[c] += (int64_t)a[c]*xr;
+    }
+  }
+}
+
+#ifdef LWE_MATVEC_X86
+
+/*
+ Both SIMD kernels keep a 32 (AVX2) or 64 (AVX-512) column chunk of
+ accumulators in registers while walking down the panel. Each row loads 32-bit
+ lanes, sign extends them to 64 bits and multiplies with mul_epi32, which only
+ reads the low 32 bits of each lane, against the broadcast x[r].
+*/
+
+__attribute__((target("avx2")))
+static void lwe_panel_avx2(int64_t *acc, const int *A, size_t stride,
+                           const int *x, size_t rn, size_t cn){
+  size_t r, c, k;
+  for(c = 0; c + 32 <= cn; c += 32){
+    __m256i s[8];
+    for(k = 0; k < 8; k++){
+      s[k] = _mm256_loadu_si256((const __m256i*)(acc + c + 4*k));
+    }
+    for(r = 0; r < rn; r++){
+      const int *a = A + r*stride + c;
+      const __m256i xr = _mm256_set1_epi64x(x[r]);
+      for(k = 0; k < 4; k++){
+        __m256i v = _mm256_loadu_si256((const __m256i*)(a + 8*k));
+        __m256i lo = _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v));
+        __m256i hi = _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1));
+        s[2*k]   = _mm256_add_epi64(s[2*k],   _mm256_mul_epi32(lo, xr));
+        s[2*k+1] = _mm256_add_epi64(s[2*k+1], _mm256_mul_epi32(hi, xr));
+      }
+    }
+    for(k = 0; k < 8; k++){
+      _mm256_storeu_si256((__m256i*)(acc + c + 4*k), s[k]);
+    }
+  }
+  if(c < cn){
+    lwe_panel_scalar(acc + c, A + c, stride, x, rn, cn - c);
+  }
+}
+
+__attribute__((target("avx512f")))
+static void lwe_panel_avx512(int64_t *acc, const int *A, size_t stride,
+                             const int *x, size_t rn, size_t cn){
+  size_t r, c, k;
+  for(c = 0; c + 64 <= cn; c += 64){
+    __m512i s[8];
+    for(k = 0; k < 8; k++){
+      s[k] = _mm512_loadu_si512((const void*)(acc + c + 8*k));
+    }
+    for(r = 0; r < rn; r++){
+      const int *a = A + r*stride + c;
+      const __m512i xr = _mm512_set1_epi64(x[r]);
+      for(k = 0; k < 4; k++){
+        __m512i v = _mm512_loadu_si512((const void*)(a + 16*k));
+        __m512i lo = _mm512_cvtepi32_epi64(_mm512_castsi512_si256(v));
+        __m512i hi = _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(v, 1));
+        s[2*k]   = _mm512_add_epi64(s[2*k],   _mm512_mul_epi32(lo, xr));
+        s[2*k+1] = _mm512_add_epi64(s[2*k+1], _mm512_mul_epi32(hi, xr));
+      }
+    }
+    for(k = 0; k < 8; k++){
+      _mm512_storeu_si512((void*)(acc + c + 8*k), s[k]);
+    }
+  }
+  if(c < cn){
+    lwe_panel_avx2(acc + c, A + c, stride, x, rn, cn - c);
+  }
+}
+
+#endif
+
+static lwe_panel_kernel_t lwe_panel = lwe_panel_scalar;
+static const char *lwe_panel_name = "scalar";
+static pthread_once_t lwe_panel_once = PTHREAD_ONCE_INIT;
+
+//Run exactly once, by whichever thread gets there first; the others wait in pthread_once()
+static void lwe_matvec_select(){
+  lwe_panel_kernel_t panel = lwe_panel_scalar;
+  const char *name = "scalar";
+#ifdef LWE_MATVEC_X86
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx512f")){
+    panel = lwe_panel_avx512;
+    name = "avx512";
+  }
+  else if(__builtin_cpu_supports("avx2")){
+    panel = lwe_panel_avx2;
+    name = "avx2";
+  }
+#endif
+  lwe_panel = panel;
+  lwe_panel_name = name;
+}
+
+void lwe_matvec_init(){
+  pthread_once(&lwe_panel_once, lwe_matvec_select);
+}
+
+const char *lwe_matvec_kernel_name(){
+  lwe_matvec_init();
+  return lwe_panel_name;
+}
+
+void lwe_matvec_accumulate(int64_t *acc, const int *A, size_t stride, size_t rows, size_t cols,
+                           const int *x){
+  lwe_matvec_init();
+  lwe_panel(acc, A, stride, x, rows, cols);
+}
+
+void lwe_matvec_transposed(int *y, const int *A, size_t stride, size_t rows, size_t cols,
+                           unsigned int a_bound, const int *x, const int *e){
+  int64_t acc[LWE_MATVEC_TILE_COLS];
+  uint64_t x_bound = 0, lazy;
+  size_t r, c, r0, c0, rn, cn, pending;
+
+  lwe_matvec_init();
+
+  //Rows we may accumulate before the int64_t accumulators need a reduction
+  for(r = 0; r < rows; r++){
+    uint64_t xr = (x[r] < 0) ? -(int64_t)x[r] : x[r];
+    x_bound = (xr > x_bound) ? xr : x_bound;
+  }
+  lazy = lwe_modq_lazy_terms(((a_bound != 0) ? a_bound : MODULO_Q - 1)*x_bound);
+  if(lazy == 0){
+    lazy = 1;
+  }
+
+  for(c0 = 0; c0 < cols; c0 += LWE_MATVEC_TILE_COLS){
+    cn = (cols - c0 < LWE_MATVEC_TILE_COLS) ? cols - c0 : LWE_MATVEC_TILE_COLS;
+    for(c = 0; c < cn; c++){
+      acc[c] = (e != NULL) ? 2*(int64_t)e[c0 + c] : 0;
+    }
+
+    pending = 0;
+    for(r0 = 0; r0 < rows; r0 += rn){
+      rn = (rows - r0 < LWE_MATVEC_TILE_ROWS) ? rows - r0 : LWE_MATVEC_TILE_ROWS;
+      rn = (rn < lazy) ? rn : lazy;
+      if(pending + rn > lazy){
+        for(c = 0; c < cn; c++){
+          acc[c] = lwe_modq_reduce(acc[c]);
+        }
+        pending = 0;
+      }
+      lwe_panel(acc, A + r0*stride + c0, stride, x + r0, rn, cn);
+      pending += rn;
+    }
+
+    for(c = 0; c < cn; c++){
+      y[c0 + c] = lwe_modq_reduce(acc[c]);
+    }
+  }
+}
+
+size_t lwe_matvec_seeded_scratch_bytes(size_t cols){
+  return lwe_arena_bytes(cols*sizeof(int64_t)) + lwe_arena_bytes(LWE_MATVEC_TILE_ROWS*cols*sizeof(int));
+}
+
+void lwe_matvec_transposed_seeded(int *y, const uint8_t seed[LWE_SEED_BYTES], size_t rows, size_t cols,
+                                  const int *x, const int *e, void *scratch){
+  //Row panels are the outer loop here, so each expanded panel is used once across all columns
+  int64_t *acc = (int64_t*)scratch;
+  int *panel = (int*)((uint8_t*)scratch + lwe_arena_bytes(cols*sizeof(int64_t)));
+  uint64_t x_bound = 0, lazy;
+  size_t r, c, r0, c0, rn, cn, pending;
+
+  lwe_matvec_init();
+
+  for(r = 0; r < rows; r++){
+    uint64_t xr = (x[r] < 0) ? -(int64_t)x[r] : x[r];
+    x_bound = (xr > x_bound) ? xr : x_bound;
+  }
+  lazy = lwe_modq_lazy_terms((uint64_t)(MODULO_Q - 1)*x_bound);
+  if(lazy == 0){
+    lazy = 1;
+  }
+
+  for(c = 0; c < cols; c++){
+    acc[c] = (e != NULL) ? 2*(int64_t)e[c] : 0;
+  }
+
+  pending = 0;
+  for(r0 = 0; r0 < rows; r0 += rn){
+    rn = (rows - r0 < LWE_MATVEC_TILE_ROWS) ? rows - r0 : LWE_MATVEC_TILE_ROWS;
+    rn = (rn < lazy) ? rn : lazy;
+    if(pending + rn > lazy){
+      for(c = 0; c < cols; c++){
+        acc[c] = lwe_modq_reduce(acc[c]);
+      }
+      pending = 0;
+    }
+    lwe_expand_rows(panel, cols, seed, r0, rn, cols);
+    for(c0 = 0; c0 < cols; c0 += LWE_MATVEC_TILE_COLS){
+      cn = (cols - c0 < LWE_MATVEC_TILE_COLS) ? cols - c0 : LWE_MATVEC_TILE_COLS;
+      lwe_panel(acc + c0, panel + c0, cols, x + r0, rn, cn);
+    }
+    pending += rn;
+  }
+
+  for(c = 0; c < cols; c++){
+    y[c] = lwe_modq_reduce(acc[c]);
+  }
+}
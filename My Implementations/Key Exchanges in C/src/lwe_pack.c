@@ -0,0 +1,112 @@
+/********************************************************************************************
+ * A simple provably secure key exchange based on the learning with errors problem
+ *
+ *
+ * Based on the paper:
+ *     Jintai Ding, Xiang Xie and Xiaodong Ling - 2012
+ *
+ * Copyright (c) Jintai Ding, Xiang Xie and Xiaodong Ling for the theoretical key exchange
+ *               Afraz Arif Khan for implementing the key exchange in C and TLS
+ *
+ * Released under the MIT License; see LICENSE.txt for details.
+ ********************************************************************************************/
+
+/** \file lwe_pack.c
+ * Bit-packed wire encoding of vectors and matrices modulo q
+ */
+
+#include <assert.h>
+
+#include "lwe_pack.h"
+#include "lwe_modq.h"
+
+size_t lwe_pack_bytes(size_t count, unsigned int d){
+  return (count*(LWE_PACK_BITS - d) + 7)/8;
+}
+
+/*
+ Values enter a 64-bit bit buffer from the top of what it already holds and
+ leave it 32 bits at a time, so the buffer never holds more than 31 + 31 bits.
+*/
+void lwe_pack(uint8_t *out, const int *in, size_t count, unsigned int d){
+  const unsigned int width = LWE_PACK_BITS - d;
+  const uint64_t mask = ((uint64_t)1 << width) - 1;
+  const uint64_t half = (d > 0) ? (uint64_t)1 << (d - 1) : 0;
+  uint64_t buf = 0;
+  unsigned int nbits = 0;
+  size_t i;
+
+  assert(d < (unsigned int)LWE_PACK_BITS);
+
+  for(i = 0; i < count; i++){
+    buf |= ((((uint64_t)(uint32_t)in[i] + half) >> d) & mask) << nbits;
+    nbits += width;
+    if(nbits >= 32){
+      out[0] = (uint8_t)buf;
+      out[1] = (uint8_t)(buf >> 8);
+      out[2] = (uint8_t)(buf >> 16);
+      out[3] = (uint8_t)(buf >> 24);
+      out += 4;
+      buf >>= 32;
+      nbits -= 32;
+    }
+  }
+  while(nbits > 0){
+    *out++ = (uint8_t)buf;
+    buf >>= 8;
+    nbits = (nbits > 8) ? nbits - 8 : 0;
+  }
+}
+
+void lwe_unpack(int *out, const uint8_t *in, size_t count, unsigned int d){
+  const unsigned int width = LWE_PACK_BITS - d;
+  const uint64_t mask = ((uint64_t)1 << width) - 1;
+  size_t left = lwe_pack_bytes(count, d);
+  uint64_t buf = 0;
+  unsigned int nbits = 0;
+  size_t i;
+
+  assert(d < (unsigned int)LWE_PACK_BITS);
+
+  for(i = 0; i < count; i++){
+    if(nbits < width){
+      if(left >= 4){
+        buf |= ((uint64_t)in[0] | (uint64_t)in[1] << 8 | (uint64_t)in[2] << 16 |
+                (uint64_t)in[3] << 24) << nbits;
+        in += 4;
+        left -= 4;
+        nbits += 32;
+      }
+      else{
+        while(left > 0){
+          buf |= (uint64_t)*in++ << nbits;
+          left--;
+          nbits += 8;
+        }
+      }
+    }
+    out[i] = (d > 0) ? lwe_modq_reduce((int64_t)((buf & mask) << d)) : (int)(buf & mask);
+    buf >>= width;
+    nbits -= width;
+  }
+}
+
+size_t lwe_pack_rows_bytes(size_t rows, size_t cols, unsigned int d){
+  return rows*lwe_pack_bytes(cols, d);
+}
+
+void lwe_pack_rows(uint8_t *out, const int *in, size_t stride, size_t rows, size_t cols, unsigned int d){
+  const size_t row_bytes = lwe_pack_bytes(cols, d);
+  size_t r;
+  for(r = 0; r < rows; r++){
+    lwe_pack(out + r*row_bytes, in + r*stride, cols, d);
+  }
+}
+
+void lwe_unpack_rows(int *out, size_t stride, const uint8_t *in, size_t rows, size_t cols, unsigned int d){
+  const size_t row_bytes = lwe_pack_bytes(cols, d);
+  size_t r;
+  for(r = 0; r < rows; r++){
+    lwe_unpack(out + r*stride, in + r*row_bytes, cols, d);
+  }
+}